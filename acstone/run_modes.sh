@@ -0,0 +1,177 @@
+#!/bin/bash
+
+ACSIM=${ACSIM:-acsim}
+ACSIM_FLAGS=${ACSIM_FLAGS:--abi}
+
+if test ! $# -eq 2 || test "$1" == "--help"
+then
+    echo "This program runs each program on simulators generated with the" 1>&2
+    echo "acsim simulation modes and checks them against the interpreter:" 1>&2
+    echo "same output, exit status and number of instructions" 1>&2
+    echo "Build the programs with Makefile.archc before" 1>&2
+    echo "Use: $0 ARCH MODEL.ac" 1>&2
+    echo "ACSIM and ACSIM_FLAGS (default -abi) set acsim and its options" 1>&2
+    exit 1
+fi
+
+ARCH=$1
+MODEL_DIR=`cd \`dirname $2\` && pwd`
+MODEL=`basename $2`
+WORK=`pwd`/${ARCH}.modes
+FAILED=0
+
+# Modes run like the interpreter, named after their acsim option
+MODES="bbc smc idec"
+
+
+# Generates and builds the simulator of mode $1 with the acsim flags $2
+build()
+{
+  mkdir -p ${WORK}/$1
+  cp -r ${MODEL_DIR}/. ${WORK}/$1
+  if ! (cd ${WORK}/$1 && ${ACSIM} ${MODEL} ${ACSIM_FLAGS} $2 && make) > ${WORK}/$1.build 2>&1
+  then
+    echo "Could not build the simulator of mode $1, see ${WORK}/$1.build" 1>&2
+    exit 1
+  fi
+}
+
+# Prints what no mode may change of a run, given its stdout, stderr and
+# exit status
+result()
+{
+  cat $1
+  grep "Number of instructions executed" $2
+  echo "Exit status: $3"
+}
+
+# Runs the simulator of mode $1 with the options that follow
+run()
+{
+  MODE=$1
+  shift
+  `ls ${WORK}/${MODE}/*.x` "$@" < /dev/null > ${WORK}/stdout 2> ${WORK}/stderr
+  result ${WORK}/stdout ${WORK}/stderr $?
+}
+
+# Runs a job with the command line arguments on the fork server
+# listening on socket $1, its stdout and stderr going to $2 and $3
+fork_job()
+{
+  python3 - $1 $2 $3 <<'PY'
+import os, socket, sys
+s = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+s.connect(sys.argv[1])
+fds = [os.open("/dev/null", os.O_RDONLY)]
+fds += [os.open(f, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644) for f in sys.argv[2:4]]
+socket.send_fds(s, [b"\0"], fds)
+s.recv(64)
+end = s.recv(64).decode().split()
+sys.exit(int(end[1]) if end[0] == "exited" else 128 + int(end[1]))
+PY
+}
+
+# Checks that run $2 of program $1 got the result of the interpreter
+check()
+{
+  diff --brief --report-identical-files $1.base.out $1.$2.out || FAILED=1
+}
+
+
+# Jobs pass their descriptors to the fork server (SCM_RIGHTS), which
+# python3 does with socket.send_fds from 3.9 on
+FORK_SERVER=1
+if ! python3 -c "import socket; socket.send_fds" > /dev/null 2>&1
+then
+  echo "python3 3.9 or later not found, -fks is not checked" 1>&2
+  FORK_SERVER=0
+fi
+
+rm -rf ${WORK}
+mkdir -p ${WORK}
+
+build base ""
+for MODE in ${MODES}
+do
+  build ${MODE} -${MODE}
+done
+build pdc -pdc
+build ckp -ckp
+if test ${FORK_SERVER} -eq 1
+then
+  build fks -fks
+fi
+
+for I in `ls *.${ARCH}`
+do
+  NAME=`echo ${I} | cut -d '.' -f '1 2'`
+  OUT=${WORK}/${NAME}
+
+  run base --load=${I} > ${OUT}.base.out
+
+  for MODE in ${MODES}
+  do
+    run ${MODE} --load=${I} > ${OUT}.${MODE}.out
+    check ${OUT} ${MODE}
+  done
+
+  # The first run fills the decode cache, the second one starts from it
+  rm -rf ${WORK}/dec-cache
+  mkdir -p ${WORK}/dec-cache
+  run pdc --dec-cache-dir=${WORK}/dec-cache --load=${I} > ${OUT}.pdc-cold.out
+  check ${OUT} pdc-cold
+  run pdc --dec-cache-dir=${WORK}/dec-cache --load=${I} > ${OUT}.pdc-warm.out
+  check ${OUT} pdc-warm
+
+  # Save halfway and start again from there. The restored run only
+  # writes the output after the checkpoint; the output before it is
+  # what a saving run with stdout and stderr in one file wrote between
+  # the simulator messages printed before the program started and the
+  # one saying the checkpoint was saved (the host does not buffer
+  # either stream)
+  COUNT=`grep "Number of instructions executed" ${OUT}.base.out | awk '{ print $5 }'`
+  SAVE="--checkpoint-at=$((COUNT / 2 + 1)) --checkpoint-file=${WORK}/checkpoint --load=${I}"
+  rm -f ${WORK}/checkpoint
+  run ckp ${SAVE} > ${OUT}.ckp-save.out
+  check ${OUT} ckp-save
+  START=`sed '/ArchC: Checkpoint saved to/,$d' ${WORK}/stderr | wc -c`
+  `ls ${WORK}/ckp/*.x` ${SAVE} < /dev/null > ${WORK}/both 2>&1
+  SAVED=`grep -a -b -o "ArchC: Checkpoint saved to" ${WORK}/both | head -n 1 | cut -d ':' -f 1`
+  if test -z "${SAVED}" || ! cmp -s -n ${START} ${WORK}/both ${WORK}/stderr
+  then
+    echo "Could not find the output of ${NAME} before its checkpoint, see ${WORK}/both" 1>&2
+    FAILED=1
+  else
+    head -c ${SAVED} ${WORK}/both | tail -c +$((START + 1)) > ${WORK}/ckp-stdout
+    `ls ${WORK}/ckp/*.x` --restore=${WORK}/checkpoint --load=${I} < /dev/null > ${WORK}/stdout 2> ${WORK}/stderr
+    STATUS=$?
+    cat ${WORK}/stdout >> ${WORK}/ckp-stdout
+    result ${WORK}/ckp-stdout ${WORK}/stderr ${STATUS} > ${OUT}.ckp-restore.out
+    check ${OUT} ckp-restore
+  fi
+
+  if test ${FORK_SERVER} -eq 0
+  then
+    continue
+  fi
+
+  # Two jobs in a row, each one from the state left by loading
+  SOCKET=${WORK}/socket
+  rm -f ${SOCKET}
+  `ls ${WORK}/fks/*.x` --fork-server=${SOCKET} --load=${I} < /dev/null > ${WORK}/fks.log 2>&1 &
+  SERVER=$!
+  while test ! -S ${SOCKET} && kill -0 ${SERVER} 2> /dev/null
+  do
+    sleep 0.1
+  done
+  for JOB in 1 2
+  do
+    fork_job ${SOCKET} ${WORK}/stdout ${WORK}/stderr
+    result ${WORK}/stdout ${WORK}/stderr $? > ${OUT}.fks-job${JOB}.out
+    check ${OUT} fks-job${JOB}
+  done
+  kill -TERM ${SERVER}
+  wait ${SERVER}
+done
+
+exit ${FAILED}
@@ -0,0 +1,595 @@
+// Replays the data accesses recorded by a simulator through a set of cache
+// configurations and prints their hit and miss counts side by side, so a
+// cache can be sized without running the simulation again. The trace is
+// either a --trace-cache file ("r|w <address> <length>" lines, in
+// hexadecimal) or a --bin-trace file opened with data accesses (see
+// actrace -m). It is read a chunk at a time, so traces of any length can
+// be replayed; accesses wider than a word (block reads and writes of the
+// memory port) go through the caches a word at a time.
+//
+// Each -c <ways>,<blocks>,<block size>[,wb|wt[,<replacement>]] adds a
+// configuration, ways being a number or "dm"; without -c, a default set
+// comparing capacities, block sizes and policies is replayed. Cache
+// geometry is a template parameter of ac_write_back_cache and
+// ac_write_through_cache, so only the geometries instantiated in the
+// geometries table below can be replayed, with either write policy and
+// any replacement policy; -l lists them. The configurations are replayed
+// in parallel, one per host thread, over the same trace.
+//
+// With -d, it instead computes LRU stack distances for every power of 2
+// number of sets up to -s (4096) with blocks of -b (32) bytes, and prints
+// the miss ratio of each of them with 1 to -w (16) ways: every LRU cache of
+// that block size in a single pass per set count.
+//
+// Usage: acreplay [-j <threads>] [-l] [-c <config>]... [-d [-b <block size>]
+//                 [-s <sets>] [-w <ways>]] <trace>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ac_cache.H"
+#include "ac_fifo_replacement_policy.H"
+#include "ac_random_replacement_policy.H"
+#include "ac_plrum_replacement_policy.H"
+#include "ac_lru_replacement_policy.H"
+#include "ac_stack_distance.H"
+#include "ac_bin_trace.H"
+
+typedef uint32_t word;
+
+struct trace_access
+{
+  uint32_t address;
+  uint32_t length;
+  bool write;
+};
+
+// Accesses read from the trace at a time. Every configuration replays a
+// chunk before the next one is read.
+static const size_t chunk_size = 1 << 20;
+
+static std::vector<trace_access> chunk;
+static const char *trace_name;
+
+// Backing store of the replayed caches. Only the hit and miss counts are
+// wanted, so every block reads as zeros and writes are dropped; the store
+// is shared by all the threads.
+class replay_memory
+{
+  static const word zeros[64];
+
+public:
+  const word *read_block(uint32_t address, unsigned length) { return zeros; }
+  void write_block(uint32_t address, const word *data, unsigned length) {}
+  uint32_t get_size() { return MEM_SIZE_; }
+  void setBlockSize(unsigned size) {}
+};
+
+const word replay_memory::zeros[64] = { 0 };
+
+// A cache replaying the trace
+class replayer
+{
+public:
+  virtual ~replayer() {}
+  virtual void replay(const std::vector<trace_access> &accesses) = 0;
+  virtual void get_statistics(cache_statistics *statistics) = 0;
+};
+
+template <class cache>
+class cache_replayer : public replayer
+{
+  replay_memory memory;
+  cache c;
+
+public:
+  // proc id 0 owns the directory of write-through caches
+  cache_replayer() : c(memory, 0) {}
+
+  void replay(const std::vector<trace_access> &accesses)
+  {
+    static const word data[2] = { 0, 0 };
+
+    for (std::vector<trace_access>::const_iterator a = accesses.begin(); a != accesses.end(); ++a)
+    {
+      if (a->write)
+        c.write(a->address, data, a->length);
+      else
+        c.read(a->address, a->length);
+    }
+  }
+
+  void get_statistics(cache_statistics *statistics) { c.get_statistics(statistics); }
+};
+
+template <class cache>
+static replayer *make_replayer()
+{
+  return new cache_replayer<cache>;
+}
+
+static const char *const write_policies[] = { "wb", "wt" };
+static const char *const replacements[] = { "fifo", "lru", "plrum", "random" };
+static const unsigned replacement_count = sizeof(replacements) / sizeof(replacements[0]);
+
+struct geometry
+{
+  unsigned associativity;
+  unsigned blocks;
+  unsigned block_size;        // bytes
+  replayer *(*make[2][4])();  // by write policy and replacement
+};
+
+// Same parameters as an ac_cache declaration: associativity, number of
+// blocks, block size, write policy and replacement policy
+#define CACHE(assoc, blocks, size, write, rep) \
+  &make_replayer<ac_write_##write##_cache<(blocks) / (assoc), size, assoc, word, \
+                                          replay_memory, ac_##rep##_replacement_policy> >
+#define POLICIES(assoc, blocks, size, write) \
+  { CACHE(assoc, blocks, size, write, fifo), CACHE(assoc, blocks, size, write, lru), \
+    CACHE(assoc, blocks, size, write, plrum), CACHE(assoc, blocks, size, write, random) }
+#define GEOMETRY(assoc, blocks, size) \
+  { assoc, blocks, size, \
+    { POLICIES(assoc, blocks, size, back), POLICIES(assoc, blocks, size, through) } }
+// a direct mapped cache has nothing to replace
+#define DIRECT_MAPPED(blocks, size) \
+  { 1, blocks, size, \
+    { { CACHE(1, blocks, size, back, fifo), CACHE(1, blocks, size, back, fifo), \
+        CACHE(1, blocks, size, back, fifo), CACHE(1, blocks, size, back, fifo) }, \
+      { CACHE(1, blocks, size, through, fifo), CACHE(1, blocks, size, through, fifo), \
+        CACHE(1, blocks, size, through, fifo), CACHE(1, blocks, size, through, fifo) } } }
+
+static const geometry geometries[] = {
+  DIRECT_MAPPED(128, 32),
+  DIRECT_MAPPED(256, 32),
+  DIRECT_MAPPED(512, 32),
+  DIRECT_MAPPED(1024, 32),
+  DIRECT_MAPPED(2048, 32),
+  GEOMETRY(2, 128, 32),
+  GEOMETRY(2, 256, 32),
+  GEOMETRY(2, 512, 32),
+  GEOMETRY(2, 1024, 32),
+  GEOMETRY(2, 2048, 32),
+  GEOMETRY(4, 128, 32),
+  GEOMETRY(4, 256, 32),
+  GEOMETRY(4, 512, 32),
+  GEOMETRY(4, 1024, 32),
+  GEOMETRY(4, 2048, 32),
+  GEOMETRY(8, 128, 32),
+  GEOMETRY(8, 256, 32),
+  GEOMETRY(8, 512, 32),
+  GEOMETRY(8, 1024, 32),
+  GEOMETRY(8, 2048, 32),
+  GEOMETRY(4, 1024, 16),
+  GEOMETRY(4, 256, 64),
+  GEOMETRY(4, 128, 128),
+};
+
+static const size_t geometry_count = sizeof(geometries) / sizeof(geometries[0]);
+
+struct config
+{
+  const geometry *g;
+  unsigned write;             // index in write_policies
+  unsigned replacement;       // index in replacements
+  replayer *r;
+  cache_statistics statistics;
+};
+
+static std::vector<config> configs;
+
+// Replayed without -c: capacity, block size, replacement policy and write
+// policy
+static const char *const default_configs[] = {
+  "dm,128,32", "dm,256,32", "dm,512,32", "dm,1024,32", "dm,2048,32",
+  "2w,128,32", "2w,256,32", "2w,512,32", "2w,1024,32", "2w,2048,32",
+  "4w,128,32", "4w,256,32", "4w,512,32", "4w,1024,32", "4w,2048,32",
+  "8w,128,32", "8w,256,32", "8w,512,32", "8w,1024,32", "8w,2048,32",
+  "4w,1024,16", "4w,256,64", "4w,128,128",
+  "4w,512,32,wb,fifo", "4w,512,32,wb,plrum", "4w,512,32,wb,random",
+  "dm,512,32,wt", "4w,512,32,wt,lru",
+};
+
+// Finds the index of name in names, or returns count
+static unsigned find_name(const char *name, const char *const *names, unsigned count)
+{
+  unsigned i;
+
+  for (i = 0; i < count && strcmp(name, names[i]); i++)
+    ;
+  return i;
+}
+
+// Adds the configuration of a -c argument. Returns false if it is
+// malformed or its geometry was not instantiated.
+static bool add_config(const char *arg)
+{
+  char ways[16], write[16] = "wb", replacement[16] = "lru", *end;
+  unsigned long assoc;
+  unsigned blocks, block_size;
+  config c;
+  int fields;
+
+  fields = sscanf(arg, "%15[^,],%u,%u,%15[^,],%15s", ways, &blocks, &block_size, write, replacement);
+  if (fields < 3 || strchr(replacement, ','))
+    return false;
+  if (!strcmp(ways, "dm"))
+    assoc = 1;
+  else if ((assoc = strtoul(ways, &end, 10)) == 0 || (*end && strcmp(end, "w")))
+    return false;
+
+  c.write = find_name(write, write_policies, 2);
+  c.replacement = find_name(replacement, replacements, replacement_count);
+  if (c.write == 2 || c.replacement == replacement_count)
+    return false;
+  for (c.g = geometries; c.g < geometries + geometry_count; c.g++)
+    if (c.g->associativity == assoc && c.g->blocks == blocks && c.g->block_size == block_size)
+      break;
+  if (c.g == geometries + geometry_count)
+    return false;
+
+  c.r = c.g->make[c.write][c.replacement]();
+  configs.push_back(c);
+  return true;
+}
+
+static void corrupt()
+{
+  fprintf(stderr, "acreplay: %s: corrupt or truncated trace\n", trace_name);
+  exit(EXIT_FAILURE);
+}
+
+// Reads an unsigned LEB128 value. Returns false at the end of the file.
+static bool get_leb128(FILE *in, uint64_t *value)
+{
+  unsigned shift = 0;
+  int c;
+
+  *value = 0;
+  while ((c = getc_unlocked(in)) != EOF)
+  {
+    if (shift > 63)
+      corrupt();
+    *value |= (uint64_t) (c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+    shift += 7;
+  }
+  if (shift)
+    corrupt();
+  return false;
+}
+
+// Reads the next data access of a --bin-trace file, past its magic.
+// Returns false at the end of the file.
+static bool get_bin_access(FILE *in, trace_access *a)
+{
+  static uint32_t addr = 0;
+  uint64_t tag, arg;
+
+  while (get_leb128(in, &tag))
+  {
+    if (!get_leb128(in, &arg))
+      corrupt();
+    if ((tag & 3) == AC_BIN_TRACE_INSTR)
+      continue;
+    if ((tag & 3) != AC_BIN_TRACE_READ && (tag & 3) != AC_BIN_TRACE_WRITE)
+      corrupt();
+
+    uint64_t z = tag >> 2;
+    addr = (uint32_t) (addr + ((z & 1) ? -(int64_t) (z >> 1) - 1 : (int64_t) (z >> 1)));
+
+    a->address = addr;
+    a->length = (uint32_t) arg;
+    a->write = (tag & 3) == AC_BIN_TRACE_WRITE;
+    return true;
+  }
+  return false;
+}
+
+// Reads a hexadecimal number and the blank that ends it
+static bool get_hex(FILE *in, uint32_t *value)
+{
+  int c, digits = 0;
+
+  *value = 0;
+  while ((c = getc_unlocked(in)) != EOF)
+  {
+    if (c >= '0' && c <= '9')
+      *value = (*value << 4) | (c - '0');
+    else if (c >= 'a' && c <= 'f')
+      *value = (*value << 4) | (c - 'a' + 10);
+    else
+      break;
+    digits++;
+  }
+  if (c == '\r')
+    c = getc_unlocked(in);
+  return digits > 0 && (c == ' ' || c == '\n' || c == EOF);
+}
+
+// Reads the next access of a --trace-cache file. Returns false at the end
+// of the file.
+static bool get_text_access(FILE *in, trace_access *a)
+{
+  int c;
+
+  if ((c = getc_unlocked(in)) == EOF)
+    return false;
+  if ((c != 'r' && c != 'w') || getc_unlocked(in) != ' ' ||
+      !get_hex(in, &a->address) || !get_hex(in, &a->length))
+    corrupt();
+  a->write = c == 'w';
+  return true;
+}
+
+// Reads the next chunk of the trace, splitting accesses wider than a word
+// at word boundaries as the memory port splits them for a cache. Returns
+// false at the end of the trace.
+static bool read_chunk(FILE *in, bool binary)
+{
+  trace_access a;
+
+  chunk.clear();
+  while (chunk.size() < chunk_size &&
+         (binary ? get_bin_access(in, &a) : get_text_access(in, &a)))
+  {
+    if (a.length == 0)
+      a.length = sizeof(word);
+    if (a.length <= sizeof(word))
+    {
+      chunk.push_back(a);
+      continue;
+    }
+    uint32_t left = a.length;
+
+    while (left)
+    {
+      a.length = std::min<uint32_t>(left, sizeof(word) - a.address % sizeof(word));
+      chunk.push_back(a);
+      a.address += a.length;
+      left -= a.length;
+    }
+  }
+  return !chunk.empty();
+}
+
+static std::vector<ac_stack_distance *> stacks;
+
+static void replay_config(size_t i)
+{
+  configs[i].r->replay(chunk);
+}
+
+static void replay_stack(size_t i)
+{
+  ac_stack_distance *s = stacks[i];
+
+  for (std::vector<trace_access>::const_iterator a = chunk.begin(); a != chunk.end(); ++a)
+    s->access(a->address);
+}
+
+// Runs the jobs left, taking the next one from next
+static void worker(void (*job)(size_t), size_t count, std::atomic<size_t> *next)
+{
+  size_t i;
+
+  while ((i = next->fetch_add(1)) < count)
+    job(i);
+}
+
+// Runs job(0) to job(count - 1) on threads threads
+static void run_jobs(void (*job)(size_t), size_t count, unsigned threads)
+{
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+
+  if (threads > count)
+    threads = count;
+  for (unsigned i = 0; i < threads; i++)
+    pool.push_back(std::thread(worker, job, count, &next));
+  for (unsigned i = 0; i < threads; i++)
+    pool[i].join();
+}
+
+static void print_geometry(FILE *out, const geometry &g)
+{
+  char assoc[16];
+
+  if (g.associativity == 1)
+    strcpy(assoc, "dm");
+  else
+    snprintf(assoc, sizeof(assoc), "%uw", g.associativity);
+  fprintf(out, "%-4s %6u %5u", assoc, g.blocks, g.block_size);
+}
+
+static void print_config(FILE *out, const config &c)
+{
+  print_geometry(out, *c.g);
+  fprintf(out, "  %s  %-6s %6uK", write_policies[c.write],
+          c.g->associativity == 1 ? "none" : replacements[c.replacement],
+          c.g->blocks * c.g->block_size / 1024);
+}
+
+static double rate(unsigned long long part, unsigned long long total)
+{
+  return total ? 100.0 * part / total : 0.0;
+}
+
+// Prints a byte count in K or M when exact
+static void print_size(FILE *out, unsigned long long size)
+{
+  if (size >= 1024 * 1024 && size % (1024 * 1024) == 0)
+    fprintf(out, " %7lluM", size / (1024 * 1024));
+  else if (size >= 1024 && size % 1024 == 0)
+    fprintf(out, " %7lluK", size / 1024);
+  else
+    fprintf(out, " %8llu", size);
+}
+
+// Prints the LRU miss ratio of every number of sets and ways
+static void print_stacks(unsigned block_size)
+{
+  unsigned ways = stacks[0]->max_ways();
+
+  printf("LRU miss ratio, %u-byte blocks\n\n", block_size);
+  printf("%6s %8s", "sets", "way size");
+  for (unsigned w = 1; w <= ways; w *= 2)
+    printf(" %6uw", w);
+  printf("\n");
+
+  for (size_t i = 0; i < stacks.size(); i++)
+  {
+    const ac_stack_distance &s = *stacks[i];
+
+    printf("%6u", s.sets());
+    print_size(stdout, (unsigned long long) s.sets() * block_size);
+    for (unsigned w = 1; w <= ways; w *= 2)
+      printf(" %6.2f%%", rate(s.misses(w), s.accesses()));
+    printf("\n");
+  }
+}
+
+static bool power_of_2(unsigned n)
+{
+  return n && !(n & (n - 1));
+}
+
+int main(int argc, char *argv[])
+{
+  char magic[AC_BIN_TRACE_MAGIC_SIZE];
+  unsigned threads = std::thread::hardware_concurrency();
+  unsigned block_size = 32, max_sets = 4096, max_ways = 16;
+  bool list = false, distances = false, binary;
+  std::vector<const char *> config_args;
+  unsigned long long accesses = 0;
+  FILE *in;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "j:lc:db:s:w:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'j':
+        threads = atoi(optarg);
+        break;
+      case 'l':
+        list = true;
+        break;
+      case 'c':
+        config_args.push_back(optarg);
+        break;
+      case 'd':
+        distances = true;
+        break;
+      case 'b':
+        block_size = atoi(optarg);
+        break;
+      case 's':
+        max_sets = atoi(optarg);
+        break;
+      case 'w':
+        max_ways = atoi(optarg);
+        break;
+      default:
+        optind = argc + 1;
+    }
+  }
+  if (list)
+  {
+    printf("%-4s %6s %5s\n", "ways", "blocks", "block");
+    for (size_t i = 0; i < geometry_count; i++)
+    {
+      print_geometry(stdout, geometries[i]);
+      putchar('\n');
+    }
+    printf("\nwith write policy wb or wt and replacement fifo, lru, plrum or random\n");
+    return EXIT_SUCCESS;
+  }
+  if (argc - optind != 1)
+  {
+    fprintf(stderr, "Usage: %s [-j <threads>] [-l] [-c <ways>,<blocks>,<block size>"
+            "[,wb|wt[,<replacement>]]]... [-d [-b <block size>] [-s <sets>] [-w <ways>]] "
+            "<trace>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (!power_of_2(block_size) || !power_of_2(max_sets) || max_ways < 1)
+  {
+    fprintf(stderr, "acreplay: block size and sets must be powers of 2\n");
+    return EXIT_FAILURE;
+  }
+  if (threads < 1)
+    threads = 1;
+
+  if (config_args.empty())
+    config_args.assign(default_configs, default_configs +
+                       sizeof(default_configs) / sizeof(default_configs[0]));
+  if (!distances)
+    for (size_t i = 0; i < config_args.size(); i++)
+      if (!add_config(config_args[i]))
+      {
+        fprintf(stderr, "acreplay: %s: not a cache configuration replay can simulate "
+                "(see acreplay -l)\n", config_args[i]);
+        return EXIT_FAILURE;
+      }
+
+  trace_name = argv[optind];
+  if ((in = fopen(trace_name, "rb")) == NULL)
+  {
+    perror(trace_name);
+    return EXIT_FAILURE;
+  }
+  binary = fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+           !memcmp(magic, AC_BIN_TRACE_MAGIC, sizeof(magic));
+  if (!binary)
+    rewind(in);
+
+  if (distances)
+  {
+    for (unsigned sets = 1; sets <= max_sets; sets *= 2)
+      stacks.push_back(new ac_stack_distance(sets, block_size, max_ways));
+    while (read_chunk(in, binary))
+    {
+      run_jobs(replay_stack, stacks.size(), threads);
+      accesses += chunk.size();
+    }
+    fclose(in);
+    printf("%s: %llu accesses\n\n", trace_name, accesses);
+    print_stacks(block_size);
+    return EXIT_SUCCESS;
+  }
+
+  while (read_chunk(in, binary))
+  {
+    run_jobs(replay_config, configs.size(), threads);
+    accesses += chunk.size();
+  }
+  fclose(in);
+  printf("%s: %llu accesses\n\n", trace_name, accesses);
+
+  printf("%-4s %6s %5s  %s  %-6s %7s %12s %7s %12s %7s %12s\n",
+         "ways", "blocks", "block", "wp", "repl", "size",
+         "read miss", "%", "write miss", "%", "evictions");
+  for (size_t i = 0; i < configs.size(); i++)
+  {
+    cache_statistics &s = configs[i].statistics;
+
+    configs[i].r->get_statistics(&s);
+    delete configs[i].r;
+
+    unsigned long long reads = s.read_hit + s.read_miss;
+    unsigned long long writes = s.write_hit + s.write_miss;
+
+    print_config(stdout, configs[i]);
+    printf(" %12llu %6.2f%% %12llu %6.2f%% %12llu\n",
+           s.read_miss, rate(s.read_miss, reads),
+           s.write_miss, rate(s.write_miss, writes), s.evictions);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file      ac_call_thread.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Call-threaded block builder used by acsim simulators.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_call_thread.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Bytes emitted per instruction, plus the block prologue and epilogue
+static const size_t ac_call_thread_instr_size = 38;
+static const size_t ac_call_thread_block_size = 4 + 2;
+
+ac_call_thread::ac_call_thread() :
+  buffer(0), used(0), pos(0), failed(false), blocks(0), instructions(0) {}
+
+ac_call_thread::~ac_call_thread() {
+  if (buffer)
+    munmap(buffer, AC_CT_BUFFER_SIZE);
+}
+
+void ac_call_thread::emit32(unsigned v) {
+  for (int i = 0; i < 4; i++, v >>= 8)
+    emit8(v & 0xff);
+}
+
+void ac_call_thread::emit64(unsigned long long v) {
+  for (int i = 0; i < 8; i++, v >>= 8)
+    emit8(v & 0xff);
+}
+
+// Sets the protection of the pages a block starting at start may use
+bool ac_call_thread::protect(size_t start, int prot) {
+  static const size_t page = sysconf(_SC_PAGESIZE);
+  size_t first = start - start % page;
+  size_t end = start + ac_call_thread_block_size + AC_CT_MAX_BLOCK * ac_call_thread_instr_size;
+
+  end = std::min((end + page - 1) / page * page, (size_t) AC_CT_BUFFER_SIZE);
+  if (mprotect(buffer + first, end - first, prot) == 0)
+    return true;
+  AC_WARN("Could not protect memory for call-threaded code. Using the interpreter only.");
+  failed = true;
+  return false;
+}
+
+bool ac_call_thread::begin_block() {
+#if defined(__x86_64__)
+  if (!buffer && !failed) {
+    void* p = mmap(0, AC_CT_BUFFER_SIZE, PROT_READ,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      AC_WARN("Could not map memory for call-threaded code. Using the interpreter only.");
+      failed = true;
+    }
+    else
+      buffer = (unsigned char*) p;
+  }
+#else
+  failed = true;
+#endif
+
+  if (failed ||
+      used + ac_call_thread_block_size + AC_CT_MAX_BLOCK * ac_call_thread_instr_size > AC_CT_BUFFER_SIZE ||
+      !protect(used, PROT_READ | PROT_WRITE))
+    return false;
+
+  pos = used;
+  exits.clear();
+
+  // push %rbx; mov %rdi, %rbx (rbx keeps proc across the calls)
+  emit8(0x53);
+  emit8(0x48); emit8(0x89); emit8(0xfb);
+  return true;
+}
+
+void ac_call_thread::emit_call(void* fn, void* dec, unsigned next_pc) {
+  // mov %rbx, %rdi
+  emit8(0x48); emit8(0x89); emit8(0xdf);
+  // movabs $dec, %rsi
+  emit8(0x48); emit8(0xbe); emit64((unsigned long long) dec);
+  // mov $next_pc, %edx
+  emit8(0xba); emit32(next_pc);
+  // movabs $fn, %rax; call *%rax
+  emit8(0x48); emit8(0xb8); emit64((unsigned long long) fn);
+  emit8(0xff); emit8(0xd0);
+  // test %eax, %eax; jnz epilogue
+  emit8(0x85); emit8(0xc0);
+  emit8(0x0f); emit8(0x85);
+  exits.push_back(pos);
+  emit32(0);
+  instructions++;
+}
+
+ac_call_thread::block_t ac_call_thread::end_block() {
+  block_t block = (block_t) (buffer + used);
+
+  for (size_t i = 0; i < exits.size(); i++) {
+    size_t p = pos;
+    pos = exits[i];
+    emit32(p - (exits[i] + 4));
+    pos = p;
+  }
+
+  // pop %rbx; ret
+  emit8(0x5b);
+  emit8(0xc3);
+
+  if (!protect(used, PROT_READ | PROT_EXEC))
+    return 0;
+  used = pos;
+  blocks++;
+  return block;
+}
+
+void ac_call_thread::print_statistics(std::ostream &out) const {
+  out << "    Call-threaded blocks: " << blocks << " (" << instructions
+      << " instructions, " << used / 1024 << " KB of host code)" << std::endl;
+}
@@ -0,0 +1,453 @@
+/**
+ * @file      ac_checkpoint.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Architectural checkpoints of a processor.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_checkpoint.H"
+#include "ac_guest_files.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+// File layout: header, then sections of a name length (with its NUL), the
+// name, a 64 bit size and size bytes of data, in host byte order.
+//
+// A memory section holds its size, then every page not made of zeros as
+// its number followed by pairs of 16 bit counts, zero words then literal
+// words, each pair followed by its literals, until the page is covered;
+// page number ~0 ends it. A page is ac_ckp_page_words words.
+static const char ac_ckp_magic[8] = { 'A', 'C', 'C', 'K', 'P', 'T', '0', '1' };
+static const unsigned ac_ckp_page_words = 1024;
+static const unsigned ac_ckp_page_size = ac_ckp_page_words * sizeof(uint32_t);
+
+struct ac_ckp_header {
+  char magic[8];
+  uint64_t count;
+};
+
+std::vector<ac_checkpoint*> ac_checkpoint::instances;
+
+static bool zero_page(const uint32_t* page, unsigned words) {
+  for (unsigned i = 0; i < words; i++)
+    if (page[i])
+      return false;
+  return true;
+}
+
+static void append(std::vector<char>& buf, const void* data, size_t size) {
+  buf.insert(buf.end(), (const char*) data, (const char*) data + size);
+}
+
+static void encode_page(std::vector<char>& buf, const uint32_t* page) {
+  unsigned i = 0;
+
+  while (i < ac_ckp_page_words) {
+    uint16_t zeros = 0, literals = 0;
+
+    while (i + zeros < ac_ckp_page_words && !page[i + zeros])
+      zeros++;
+    // a single zero word between literals costs less as a literal
+    while (i + zeros + literals < ac_ckp_page_words &&
+           (page[i + zeros + literals] ||
+            (i + zeros + literals + 1 < ac_ckp_page_words &&
+             page[i + zeros + literals + 1])))
+      literals++;
+
+    append(buf, &zeros, sizeof(zeros));
+    append(buf, &literals, sizeof(literals));
+    append(buf, page + i + zeros, literals * sizeof(uint32_t));
+    i += zeros + literals;
+  }
+}
+
+static bool decode_page(const char*& p, const char* end, uint32_t* page) {
+  unsigned i = 0;
+
+  while (i < ac_ckp_page_words) {
+    uint16_t zeros, literals;
+
+    if (end - p < 4)
+      return false;
+    memcpy(&zeros, p, sizeof(zeros));
+    memcpy(&literals, p + 2, sizeof(literals));
+    p += 4;
+    if (i + zeros + literals > ac_ckp_page_words ||
+        (size_t) (end - p) < literals * sizeof(uint32_t))
+      return false;
+
+    memset(page + i, 0, zeros * sizeof(uint32_t));
+    memcpy(page + i + zeros, p, literals * sizeof(uint32_t));
+    p += literals * sizeof(uint32_t);
+    i += zeros + literals;
+  }
+  return true;
+}
+
+ac_checkpoint::ac_checkpoint() :
+  out(0), next(0), saved(0), restored_at(~0ULL), save_at(~0ULL) {}
+
+ac_checkpoint::~ac_checkpoint() {
+  instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+  if (out) {
+    fclose(out);
+    unlink(out_path.c_str());
+  }
+}
+
+void ac_checkpoint::open(const char* proc) {
+  this->proc = proc;
+  if (ac_checkpoint_at)
+    save_at = ac_checkpoint_at;
+  if (ac_checkpoint_syscall)
+    save_syscall = ac_checkpoint_syscall;
+  if (ac_checkpoint_file)
+    file = ac_checkpoint_file;
+  instances.push_back(this);
+}
+
+bool ac_checkpoint::syscall(const char* name) {
+  if (save_syscall.empty() || save_syscall != name)
+    return false;
+  save_syscall.clear();
+  return true;
+}
+
+void ac_checkpoint::request(int signal) {
+  for (size_t i = 0; i < instances.size(); i++)
+    instances[i]->save_at = 0;
+}
+
+bool ac_checkpoint::begin_save(unsigned long long count) {
+  std::ostringstream name;
+  ac_ckp_header header;
+
+  if (save_at <= count)
+    save_at = ~0ULL;
+
+  if (file.empty())
+    name << proc << "." << count << ".ckpt";
+  else
+    name << file;
+  path = ac_output_name(name.str());
+
+  // A private temporary file keeps runs restoring the same checkpoint
+  // from seeing it half written.
+  name.str("");
+  name << path << "." << getpid();
+  out_path = name.str();
+  out = fopen(out_path.c_str(), "wb");
+  if (!out) {
+    AC_WARN("Could not write checkpoint " << out_path << ".");
+    return false;
+  }
+
+  memcpy(header.magic, ac_ckp_magic, sizeof(ac_ckp_magic));
+  header.count = count;
+  fwrite(&header, sizeof(header), 1, out);
+  put("processor", proc.c_str(), proc.size() + 1);
+  return true;
+}
+
+void ac_checkpoint::put(const char* name, const void* data, size_t size) {
+  uint32_t length = strlen(name) + 1;
+  uint64_t size64 = size;
+
+  fwrite(&length, sizeof(length), 1, out);
+  fwrite(name, 1, length, out);
+  fwrite(&size64, sizeof(size64), 1, out);
+  fwrite(data, 1, size, out);
+}
+
+void ac_checkpoint::put_memory(const char* name, const uint8_t* data, uint32_t size) {
+  std::vector<char> buf;
+  uint32_t pages = (size + ac_ckp_page_size - 1) / ac_ckp_page_size;
+  uint32_t last = ~0u;
+
+  append(buf, &size, sizeof(size));
+  for (uint32_t n = 0; n < pages; n++) {
+    uint32_t page[ac_ckp_page_words];
+    uint32_t offset = n * ac_ckp_page_size;
+    uint32_t bytes = std::min(ac_ckp_page_size, size - offset);
+
+    memset(page, 0, sizeof(page));
+    memcpy(page, data + offset, bytes);
+    if (zero_page(page, ac_ckp_page_words))
+      continue;
+
+    append(buf, &n, sizeof(n));
+    encode_page(buf, page);
+  }
+  append(buf, &last, sizeof(last));
+
+  put(name, &buf[0], buf.size());
+}
+
+void ac_checkpoint::put_files() {
+  std::vector<char> buf;
+
+  for (std::map<int, ac_guest_file>::const_iterator f = ac_guest_files.begin();
+       f != ac_guest_files.end(); ++f) {
+    int32_t fields[4] = { f->first, f->second.flags, f->second.mode, f->second.dup_of };
+    int64_t offset = lseek(f->first, 0, SEEK_CUR);
+    uint32_t length = f->second.path.size();
+
+    append(buf, fields, sizeof(fields));
+    append(buf, &offset, sizeof(offset));
+    append(buf, &length, sizeof(length));
+    append(buf, f->second.path.data(), length);
+  }
+
+  put("files", buf.empty() ? "" : &buf[0], buf.size());
+}
+
+void ac_checkpoint::end_save() {
+  bool ok = !ferror(out);
+
+  ok = (fclose(out) == 0) && ok;
+  out = 0;
+
+  if (!ok || rename(out_path.c_str(), path.c_str()) != 0) {
+    AC_WARN("Could not write checkpoint " << path << ".");
+    unlink(out_path.c_str());
+    return;
+  }
+  saved++;
+  AC_SAY("Checkpoint saved to " << path);
+}
+
+void ac_checkpoint::fail(const char* what) {
+  AC_ERROR("Could not restore checkpoint " << in_path << ": " << what << ".");
+  exit(EXIT_FAILURE);
+}
+
+unsigned long long ac_checkpoint::begin_restore(const char* file) {
+  ac_ckp_header header;
+  FILE* input;
+  long size;
+  size_t length;
+  const char* name;
+
+  in_path = file;
+  input = fopen(file, "rb");
+  if (!input)
+    fail(strerror(errno));
+
+  if (fseek(input, 0, SEEK_END) != 0 || (size = ftell(input)) < (long) sizeof(header) ||
+      fseek(input, 0, SEEK_SET) != 0)
+    fail("not a checkpoint");
+  in.resize(size);
+  if (fread(&in[0], 1, size, input) != (size_t) size)
+    fail("read error");
+  fclose(input);
+
+  memcpy(&header, &in[0], sizeof(header));
+  if (memcmp(header.magic, ac_ckp_magic, sizeof(ac_ckp_magic)))
+    fail("not a checkpoint");
+  next = sizeof(header);
+
+  name = (const char*) get("processor", length);
+  if (!length || name[length - 1] || proc != name)
+    AC_WARN("Restoring checkpoint of processor " << std::string(name, length ? length - 1 : 0)
+            << " into " << proc << ".");
+
+  restored_at = header.count;
+  return header.count;
+}
+
+const void* ac_checkpoint::get(const char* name, size_t& size) {
+  uint32_t length;
+  uint64_t size64;
+  const char* section;
+
+  if (in.size() - next < sizeof(length))
+    fail("truncated file");
+  memcpy(&length, &in[next], sizeof(length));
+  next += sizeof(length);
+  if (in.size() - next < length + sizeof(size64))
+    fail("truncated file");
+  section = &in[next];
+  if (length != strlen(name) + 1 || memcmp(section, name, length)) {
+    std::string what = std::string("expected ") + name + ", found " +
+      std::string(section, strnlen(section, length));
+    fail(what.c_str());
+  }
+  next += length;
+
+  memcpy(&size64, &in[next], sizeof(size64));
+  next += sizeof(size64);
+  if (in.size() - next < size64)
+    fail("truncated file");
+
+  size = size64;
+  next += size;
+  return &in[next - size];
+}
+
+void ac_checkpoint::get(const char* name, void* data, size_t size) {
+  size_t found;
+  const void* section = get(name, found);
+
+  if (found != size) {
+    std::string what = std::string("size of ") + name + " differs";
+    fail(what.c_str());
+  }
+  memcpy(data, section, size);
+}
+
+void ac_checkpoint::get_memory(const char* name, uint8_t* data, uint32_t size) {
+  size_t length;
+  const char* p = (const char*) get(name, length);
+  const char* end = p + length;
+  uint32_t pages = (size + ac_ckp_page_size - 1) / ac_ckp_page_size;
+  uint32_t saved_size, n, first = 0;
+
+  if (length < 2 * sizeof(uint32_t))
+    fail("truncated memory");
+  memcpy(&saved_size, p, sizeof(saved_size));
+  p += sizeof(saved_size);
+  if (saved_size != size) {
+    std::string what = std::string("size of ") + name + " differs";
+    fail(what.c_str());
+  }
+
+  for (;;) {
+    if (end - p < (long) sizeof(n))
+      fail("truncated memory");
+    memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    if (n != ~0u && (n >= pages || n < first))
+      fail("bad memory page");
+
+    // pages left out hold zeros; most are still untouched in this run
+    for (uint32_t z = first; z < std::min(n, pages); z++) {
+      uint32_t offset = z * ac_ckp_page_size;
+      uint32_t bytes = std::min(ac_ckp_page_size, size - offset);
+      if (bytes < ac_ckp_page_size || !zero_page((const uint32_t*) (data + offset), ac_ckp_page_words))
+        memset(data + offset, 0, bytes);
+    }
+    if (n == ~0u)
+      break;
+
+    uint32_t offset = n * ac_ckp_page_size;
+    uint32_t bytes = std::min(ac_ckp_page_size, size - offset);
+    if (bytes == ac_ckp_page_size) {
+      if (!decode_page(p, end, (uint32_t*) (data + offset)))
+        fail("bad memory page");
+    }
+    else {
+      uint32_t page[ac_ckp_page_words];
+      if (!decode_page(p, end, page))
+        fail("bad memory page");
+      memcpy(data + offset, page, bytes);
+    }
+    first = n + 1;
+  }
+}
+
+void ac_checkpoint::get_files() {
+  size_t length;
+  const char* p = (const char*) get("files", length);
+  const char* end = p + length;
+
+  while (p < end) {
+    int32_t fields[4];
+    int64_t offset;
+    uint32_t path_length;
+    ac_guest_file file;
+
+    if ((size_t) (end - p) < sizeof(fields) + sizeof(offset) + sizeof(path_length))
+      fail("truncated files");
+    memcpy(fields, p, sizeof(fields));
+    memcpy(&offset, p + sizeof(fields), sizeof(offset));
+    memcpy(&path_length, p + sizeof(fields) + sizeof(offset), sizeof(path_length));
+    p += sizeof(fields) + sizeof(offset) + sizeof(path_length);
+    if ((size_t) (end - p) < path_length)
+      fail("truncated files");
+    file.path.assign(p, path_length);
+    p += path_length;
+    file.flags = fields[1];
+    file.mode = fields[2];
+    file.dup_of = fields[3];
+
+    // guest descriptors are host descriptors: one the simulator opened
+    // since (a trace, a statistics file, ...) cannot be taken over
+    if (fields[0] > 2 && !ac_guest_files.count(fields[0]) && fcntl(fields[0], F_GETFD) != -1) {
+      AC_WARN("Guest file " << file.path << " not opened again: descriptor " << fields[0]
+              << " is in use by the simulator.");
+      continue;
+    }
+
+    if (file.dup_of >= 0)
+      dup2(file.dup_of, fields[0]);
+    else {
+      // the file may have grown since, so it is neither truncated nor
+      // required to be new
+      int fd = ::open(file.path.c_str(), file.flags & ~(O_TRUNC | O_EXCL), file.mode);
+      if (fd < 0) {
+        AC_WARN("Could not open guest file " << file.path << " again: " << strerror(errno) << ".");
+        continue;
+      }
+      if (fd != fields[0]) {
+        dup2(fd, fields[0]);
+        close(fd);
+      }
+      if (offset >= 0)
+        lseek(fields[0], offset, SEEK_SET);
+    }
+    ac_guest_files[fields[0]] = file;
+  }
+}
+
+void ac_checkpoint::end_restore() {
+  if (next != in.size())
+    fail("sections left over");
+  std::vector<char>().swap(in);
+  next = 0;
+}
+
+void ac_checkpoint::print_statistics(std::ostream &out) const {
+  if (restored_at != ~0ULL)
+    out << "    Restored from checkpoint: " << in_path << " at instruction "
+        << restored_at << std::endl;
+  out << "    Checkpoints saved: " << saved << std::endl;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file      ac_dec_cache_file.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Persistent (on-disk) copy of the decode cache.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <iomanip>
+#include <sstream>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_dec_cache_file.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+// File layout: header, then count records of an address followed by
+// entry_size bytes of DecCacheItem. Everything is in host byte order; the
+// model hash already differs between simulators built for other hosts.
+static const char ac_dcf_magic[8] = { 'A', 'C', 'D', 'E', 'C', 'C', 'F', '1' };
+
+struct ac_dcf_header {
+  char magic[8];
+  uint64_t model_hash;
+  uint64_t image_hash;
+  uint32_t entry_size;
+  uint32_t count;
+};
+
+unsigned long long ac_dec_cache_file::hash(const void* data, size_t size,
+                                           unsigned long long h) {
+  const unsigned char* p = (const unsigned char*) data;
+
+  for (size_t i = 0; i < size; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+ac_dec_cache_file::ac_dec_cache_file() :
+  state(OFF), model_hash(0), image_hash(0), entry_size(0), next_record(0),
+  out(0), saved_once(false), loaded(0), decoded(0), saved(0) {}
+
+ac_dec_cache_file::~ac_dec_cache_file() {
+  if (out) {
+    fclose(out);
+    unlink(out_path.c_str());
+  }
+}
+
+bool ac_dec_cache_file::open(const char* dir, const char* name,
+                             unsigned long long model, unsigned long long image,
+                             const range_list& code, unsigned entry_size,
+                             unsigned limit, unsigned max_id) {
+  std::ostringstream file_name;
+  ac_dcf_header header;
+  size_t record_size = sizeof(uint32_t) + entry_size;
+  FILE* in;
+  long size;
+  bool ok;
+
+  model_hash = model;
+  image_hash = image;
+  this->entry_size = entry_size;
+  ranges = code;
+
+  file_name << dir << "/" << name << "-" << std::hex << std::setfill('0')
+            << std::setw(16) << model << std::setw(16) << image << ".acdc";
+  path = file_name.str();
+  state = MISS;
+
+  in = fopen(path.c_str(), "rb");
+  if (!in)
+    return false;
+
+  ok = fseek(in, 0, SEEK_END) == 0 && (size = ftell(in)) >= 0 &&
+    fseek(in, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, in) == 1 &&
+    !memcmp(header.magic, ac_dcf_magic, sizeof(ac_dcf_magic)) &&
+    header.model_hash == model && header.image_hash == image &&
+    header.entry_size == entry_size &&
+    (unsigned long) size == sizeof(header) + header.count * record_size;
+
+  if (ok) {
+    records.resize(header.count * record_size);
+    ok = fread(records.data(), 1, records.size(), in) == records.size();
+  }
+  fclose(in);
+
+  // Every record must decode code covered by the image hash
+  for (size_t r = 0; ok && r < records.size(); r += record_size) {
+    uint32_t addr, id;
+    bool covered = false;
+
+    memcpy(&addr, &records[r], sizeof(addr));
+    memcpy(&id, &records[r + sizeof(addr)], sizeof(id));
+    for (size_t i = 0; i < ranges.size() && !covered; i++)
+      covered = addr >= ranges[i].first && addr < ranges[i].second;
+    ok = covered && addr < limit && id <= max_id;
+  }
+
+  if (!ok) {
+    AC_WARN("Ignoring stale decode cache file " << path << ".");
+    std::vector<char>().swap(records);
+    state = STALE;
+    return false;
+  }
+
+  loaded = header.count;
+  next_record = 0;
+  state = HIT;
+  return true;
+}
+
+const void* ac_dec_cache_file::next(unsigned& addr) {
+  const void* entry;
+  uint32_t a;
+
+  if (next_record >= records.size()) {
+    std::vector<char>().swap(records);
+    return 0;
+  }
+
+  memcpy(&a, &records[next_record], sizeof(a));
+  entry = &records[next_record + sizeof(a)];
+  next_record += sizeof(a) + entry_size;
+  addr = a;
+  return entry;
+}
+
+bool ac_dec_cache_file::begin_save() {
+  ac_dcf_header header;
+  std::ostringstream tmp_name;
+
+  if (state == OFF || saved_once || (state == HIT && !decoded))
+    return false;
+  saved_once = true;
+
+  // A private temporary file keeps concurrent simulations from seeing a
+  // half written cache.
+  mkdir(path.substr(0, path.rfind('/')).c_str(), 0777);
+  tmp_name << path << "." << getpid();
+  out_path = tmp_name.str();
+  out = fopen(out_path.c_str(), "wb");
+  if (!out) {
+    AC_WARN("Could not write decode cache file " << out_path << ".");
+    return false;
+  }
+
+  memset(&header, 0, sizeof(header));
+  fwrite(&header, sizeof(header), 1, out);
+  saved = 0;
+  return true;
+}
+
+void ac_dec_cache_file::put(unsigned addr, const void* data) {
+  uint32_t a = addr;
+
+  fwrite(&a, sizeof(a), 1, out);
+  fwrite(data, entry_size, 1, out);
+  saved++;
+}
+
+void ac_dec_cache_file::end_save() {
+  ac_dcf_header header;
+  bool ok;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ac_dcf_magic, sizeof(ac_dcf_magic));
+  header.model_hash = model_hash;
+  header.image_hash = image_hash;
+  header.entry_size = entry_size;
+  header.count = saved;
+
+  ok = fseek(out, 0, SEEK_SET) == 0 &&
+    fwrite(&header, sizeof(header), 1, out) == 1 && !ferror(out);
+  ok = (fclose(out) == 0) && ok;
+  out = 0;
+
+  if (!ok || rename(out_path.c_str(), path.c_str()) != 0) {
+    AC_WARN("Could not write decode cache file " << path << ".");
+    unlink(out_path.c_str());
+    saved = 0;
+  }
+}
+
+void ac_dec_cache_file::print_statistics(std::ostream &out) const {
+  static const char* state_names[] = { "off", "miss", "stale", "hit" };
+
+  out << "    Decode cache file: " << path << " (" << state_names[state]
+      << ")" << std::endl;
+  out << "    Decode cache file hits: " << loaded
+      << ", misses: " << decoded
+      << ", entries saved: " << saved << std::endl;
+}
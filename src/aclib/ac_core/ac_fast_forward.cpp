@@ -0,0 +1,128 @@
+/**
+ * @file      ac_fast_forward.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Switch between the functional and the detailed dispatch.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_fast_forward.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+ac_fast_forward::ac_fast_forward() :
+  detailed_(true), length(0), entered(0), detailed_instrs(0), regions(0), next_start(0),
+  leave_at(~0ULL), detail_at(~0ULL), detail_pc(~0ULL), detail_instr(~0u) {}
+
+void ac_fast_forward::read_simpoints(const char* file, unsigned long long interval) {
+  FILE* in = fopen(file, "r");
+  unsigned long long point, cluster;
+
+  if (!in) {
+    fprintf(stderr, "ArchC: Could not open simulation points %s\n", file);
+    return;
+  }
+  // one "<interval> <cluster>" line per simulation point
+  while (fscanf(in, "%llu %llu", &point, &cluster) == 2)
+    starts.push_back(point * interval);
+  fclose(in);
+
+  std::sort(starts.begin(), starts.end());
+  starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+  if (starts.empty())
+    fprintf(stderr, "ArchC: No simulation points in %s\n", file);
+}
+
+void ac_fast_forward::open(const ac_instr_info* instr_table, unsigned instrs) {
+  length = ac_detail_length;
+  if (ac_detail_at)
+    detail_at = ac_detail_at;
+
+  if (ac_simpoints) {
+    read_simpoints(ac_simpoints, ac_bbv_interval);
+    if (!starts.empty()) {
+      length = ac_bbv_interval;
+      detail_at = starts[0];
+      next_start = 1;
+    }
+  }
+  detail_pc = ac_detail_pc;
+
+  if (ac_detail_instr) {
+    for (unsigned i = 1; i <= instrs; i++)
+      if (!strcmp(instr_table[i].ac_instr_name, ac_detail_instr))
+        detail_instr = i;
+    if (detail_instr == ~0u)
+      fprintf(stderr, "ArchC: No instruction named %s, --detail-instr ignored\n", ac_detail_instr);
+  }
+
+  // without a trigger the whole run is detailed
+  if (detail_at == ~0ULL && detail_pc == ~0ULL && detail_instr == ~0u) {
+    enter(0);
+    return;
+  }
+  detailed_ = false;
+  leave_at = 0;
+}
+
+void ac_fast_forward::enter(unsigned long long count) {
+  detailed_ = true;
+  entered = count;
+  regions++;
+  detail_at = ~0ULL;
+  leave_at = length ? count + length : ~0ULL;
+}
+
+void ac_fast_forward::leave(unsigned long long count) {
+  detailed_ = false;
+  detailed_instrs += count - entered;
+  leave_at = 0;
+
+  // a region entered late, by another trigger, may cover the next points
+  while (next_start < starts.size() && starts[next_start] < count)
+    next_start++;
+  if (next_start < starts.size())
+    detail_at = starts[next_start++];
+}
+
+void ac_fast_forward::print_statistics(std::ostream &out, unsigned long long count) const {
+  unsigned long long detail = detailed_instrs + (detailed_ ? count - entered : 0);
+
+  out << "    Fast-forwarded instructions: " << count - detail << std::endl;
+  out << "    Detailed instructions: " << detail << " in " << regions
+      << (regions == 1 ? " region" : " regions") << std::endl;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file      ac_fork_server.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Batch runs forked from a loaded simulator.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_fork_server.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Largest job packet, arguments included.
+static const size_t ac_fork_job_size = 65536;
+
+// Write end of the pipe telling the server that a job exited, moved up
+// so that the guest gets the descriptors it would get in a plain run.
+static const int ac_fork_done_fd = 256;
+
+static volatile sig_atomic_t ac_fork_stopping = 0;
+
+static void ac_fork_stop(int signal) {
+  ac_fork_stopping = 1;
+}
+
+static void reply(int fd, const char* format, long value) {
+  char msg[64];
+  int size = snprintf(msg, sizeof(msg), format, value);
+
+  send(fd, msg, size, MSG_NOSIGNAL);
+}
+
+ac_fork_server::ac_fork_server() : forked(0), jobs(0), argc(0), argv(0) {}
+
+bool ac_fork_server::start(connection& conn) {
+  struct msghdr msg;
+  struct iovec iov;
+  char control[CMSG_SPACE(3 * sizeof(int))];
+  int fds[3];
+  unsigned nfds = 0;
+  int done[2];
+  int error = 0;
+  ssize_t size;
+
+  job.resize(ac_fork_job_size);
+  iov.iov_base = &job[0];
+  iov.iov_len = job.size();
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  size = recvmsg(conn.fd, &msg, 0);
+  if (size <= 0) {
+    close(conn.fd);
+    conn.fd = -1;
+    return false;
+  }
+  for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+      for (size_t i = 0; i < (c->cmsg_len - CMSG_LEN(0)) / sizeof(int); i++) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+        if (nfds < 3)
+          fds[nfds++] = fd;
+        else
+          close(fd);
+      }
+
+  if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || job[size - 1] != '\0')
+    error = EINVAL;
+  else if (pipe(done) != 0)
+    error = errno;
+  if (error) {
+    reply(conn.fd, "error %ld", error);
+    while (nfds)
+      close(fds[--nfds]);
+    return false;
+  }
+
+  args.clear();
+  for (ssize_t i = 0; i < size; i += strlen(&job[i]) + 1)
+    args.push_back(&job[i]);
+  args.push_back(0);
+  argc = job[0] ? args.size() - 1 : 0;
+  argv = &args[0];
+
+  // buffered output would be written again by every child
+  fflush(NULL);
+  std::cout.flush();
+  std::cerr.flush();
+
+  int pid = fork();
+
+  if (pid == 0) {
+    ac_fork_job = forked + 1;
+    for (size_t i = 0; i < connections.size(); i++) {
+      close(connections[i].fd);
+      if (connections[i].pid)
+        close(connections[i].done);
+    }
+    connections.clear();
+    close(done[0]);
+    if (done[1] != ac_fork_done_fd && dup2(done[1], ac_fork_done_fd) >= 0)
+      close(done[1]);
+
+    for (unsigned i = 0; i < nfds; i++)
+      dup2(fds[i], i);
+    for (unsigned i = 0; i < nfds; i++)
+      if (fds[i] > 2)
+        close(fds[i]);
+    return true;
+  }
+
+  close(done[1]);
+  while (nfds)
+    close(fds[--nfds]);
+  if (pid < 0) {
+    reply(conn.fd, "error %ld", errno);
+    close(done[0]);
+    return false;
+  }
+  forked++;
+  conn.pid = pid;
+  conn.done = done[0];
+  reply(conn.fd, "started %ld", pid);
+  return false;
+}
+
+void ac_fork_server::finish(connection& conn) {
+  int status = 0;
+
+  waitpid(conn.pid, &status, 0);
+  if (WIFSIGNALED(status))
+    reply(conn.fd, "killed %ld", WTERMSIG(status));
+  else
+    reply(conn.fd, "exited %ld", WEXITSTATUS(status));
+  close(conn.done);
+  conn.pid = 0;
+  conn.done = -1;
+  jobs++;
+}
+
+bool ac_fork_server::serve() {
+  static bool served = false;
+  struct sockaddr_un addr;
+  struct sigaction stop, old_int, old_term;
+  struct stat st;
+  int listener;
+
+  if (!ac_fork_server_socket || served)
+    return false;
+  served = true;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(ac_fork_server_socket) >= sizeof(addr.sun_path)) {
+    AC_ERROR("Fork server socket name too long: " << ac_fork_server_socket);
+    exit(EXIT_FAILURE);
+  }
+  strcpy(addr.sun_path, ac_fork_server_socket);
+
+  // a socket left by a server that was killed
+  if (stat(ac_fork_server_socket, &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(ac_fork_server_socket);
+
+  listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  if (listener < 0 || bind(listener, (struct sockaddr*) &addr, sizeof(addr)) != 0 ||
+      listen(listener, 16) != 0) {
+    AC_ERROR("Could not listen on " << ac_fork_server_socket << ": " << strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  memset(&stop, 0, sizeof(stop));
+  stop.sa_handler = ac_fork_stop;
+  sigaction(SIGINT, &stop, &old_int);
+  sigaction(SIGTERM, &stop, &old_term);
+  AC_SAY("Fork server listening on " << ac_fork_server_socket);
+
+  for (;;) {
+    std::vector<struct pollfd> fds(connections.size() + 1);
+    bool running = false;
+
+    fds[0].fd = listener;
+    fds[0].events = ac_fork_stopping ? 0 : POLLIN;
+    for (size_t i = 0; i < connections.size(); i++) {
+      running |= connections[i].pid != 0;
+      fds[i + 1].fd = connections[i].pid ? connections[i].done : connections[i].fd;
+      fds[i + 1].events = connections[i].pid || !ac_fork_stopping ? POLLIN : 0;
+    }
+    if (ac_fork_stopping && !running)
+      break;
+
+    if (poll(&fds[0], fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      AC_ERROR("Fork server: " << strerror(errno));
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      connection conn = { accept(listener, NULL, NULL), 0, -1 };
+      if (conn.fd >= 0)
+        connections.push_back(conn);
+    }
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (!fds[i].revents)
+        continue;
+      if (connections[i - 1].pid)
+        finish(connections[i - 1]);
+      else if (!ac_fork_stopping && start(connections[i - 1])) {
+        close(listener);
+        sigaction(SIGINT, &old_int, NULL);
+        sigaction(SIGTERM, &old_term, NULL);
+        return argc != 0;
+      }
+    }
+
+    for (size_t i = connections.size(); i-- > 0; )
+      if (connections[i].fd < 0)
+        connections.erase(connections.begin() + i);
+  }
+
+  for (size_t i = 0; i < connections.size(); i++)
+    close(connections[i].fd);
+  close(listener);
+  unlink(ac_fork_server_socket);
+  AC_SAY("Fork server ran " << jobs << (jobs == 1 ? " job" : " jobs"));
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file      ac_host_cost.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Sampled host cost of the interpretation routines.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdio.h>
+#include <algorithm>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_host_cost.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+ac_host_cost::ac_host_cost() :
+  countdown(0xffffffff), period(1), seed(2463534242u), overhead(0), formats(0) {}
+
+void ac_host_cost::open(unsigned period, const char* project,
+                        const ac_instr_info* instr_table, unsigned instrs,
+                        const char* const* format_names, unsigned formats) {
+  std::string prefix(project);
+
+  this->period = period ? period : 1;
+  this->formats = formats;
+  costs.assign(3 + formats + instrs, cost());
+  names.assign(costs.size(), std::string());
+
+  names[0] = "dispatch";
+  names[1] = "_behavior_instruction";
+  for (unsigned f = 1; f <= formats; f++)
+    names[1 + f] = "_behavior_" + prefix + "_" + format_names[f];
+  for (unsigned i = 1; i <= instrs; i++)
+    names[2 + formats + i] = std::string("behavior_") + instr_table[i].ac_instr_name;
+
+  // cheapest back to back reads, charged to every interval
+  overhead = ~(uint64_t) 0;
+  for (int i = 0; i < 1000; i++) {
+    uint64_t t0 = now();
+    overhead = std::min(overhead, now() - t0);
+  }
+
+  countdown = 1;
+}
+
+void ac_host_cost::reload() {
+  // xorshift32; the next sample is 1 to 2 * period - 1 instructions away
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  countdown = 1 + seed % (2 * period - 1);
+}
+
+void ac_host_cost::print_statistics(std::ostream &out) const {
+  unsigned long long total = 0;
+  std::vector<std::pair<unsigned long long, size_t> > ranked;
+  char line[160];
+
+  for (size_t i = 0; i < costs.size(); i++) {
+    if (costs[i].samples) {
+      total += costs[i].cycles;
+      ranked.push_back(std::make_pair(costs[i].cycles, i));
+    }
+  }
+  std::sort(ranked.rbegin(), ranked.rend());
+
+#if defined(__i386__) || defined(__x86_64__)
+  const char* unit = "TSC cycles";
+#else
+  const char* unit = "ns";
+#endif
+  out << "    Host cost of the routines (" << unit << ", 1 in " << period
+      << " instructions sampled on average):" << std::endl;
+  out << "       %    per call   samples  routine" << std::endl;
+  for (size_t r = 0; r < ranked.size(); r++) {
+    const cost& c = costs[ranked[r].second];
+    snprintf(line, sizeof(line), "    %6.2f %11.1f %9llu  %s",
+             total ? 100.0 * c.cycles / total : 0.0, (double) c.cycles / c.samples,
+             c.samples, names[ranked[r].second].c_str());
+    out << line << std::endl;
+  }
+}
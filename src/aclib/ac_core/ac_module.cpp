@@ -36,6 +36,7 @@
 
 // Standard includes
 #include <iostream>
+#include <limits.h>
 #include <unistd.h>
 
 // SystemC includes
@@ -61,10 +62,12 @@ std::list<ac_module*> ac_module::mods_list;
 /// Standard constructor.
 ac_module::ac_module() : sc_module(sc_gen_unique_name("ac_module")),
 			 mod_id(next_mod_id++),
-			 ac_exit_status(0){
+			 ac_exit_status(0),
+			 ac_pending_cycles(0){
   ac_qk.set_global_quantum( sc_time(100, SC_NS) );
   ac_qk.reset();
   module_period_ns=5;  //200 MHz = 5ns
+  flush_cycles();
   this_mod = mods_list.insert(mods_list.end(), this);
   return;
 }
@@ -72,10 +75,12 @@ ac_module::ac_module() : sc_module(sc_gen_unique_name("ac_module")),
 /// Named constructor.
 ac_module::ac_module(sc_module_name nm) : sc_module(nm),
 			 mod_id(next_mod_id++),
-			 ac_exit_status(0){
+			 ac_exit_status(0),
+			 ac_pending_cycles(0){
   ac_qk.set_global_quantum( sc_time(100, SC_NS) );
   ac_qk.reset();
   module_period_ns=5;  //200 MHz = 5ns
+  flush_cycles();
   this_mod = mods_list.insert(mods_list.end(), this);
   return;
 }
@@ -127,10 +132,44 @@ void ac_module::set_instr_batch_size(unsigned int size)
 void ac_module::set_quantum(unsigned int time_quantum_ns) {
   ac_qk.set_global_quantum( sc_time(time_quantum_ns, SC_NS));
   ac_qk.reset();
+  ac_pending_cycles = 0;
+  flush_cycles();
 }
 
 /// Public method that sets the processor frequency(MHz to ns) 
 void ac_module::set_proc_freq(unsigned int proc_freq_mhz) {
+  flush_cycles();  // pending cycles ran at the old period
   module_period_ns=1000/proc_freq_mhz;
+  flush_cycles();
+}
+
+/// Public method that adds the pending cycles to the quantum keeper and
+/// computes how many cycles fit before it needs to sync again.
+void ac_module::flush_cycles() {
+  sc_time period(module_period_ns, SC_NS);
+  sc_dt::uint64 left;
+
+  if (ac_pending_cycles) {
+    ac_qk.inc(period * ac_pending_cycles);
+    ac_pending_cycles = 0;
+  }
+
+  if (period == SC_ZERO_TIME) {
+    ac_sync_cycles = UINT_MAX;  // time never advances
+    return;
+  }
+  // need_sync() is true once the local time reaches the sync point
+  left = (ac_qk.time_to_sync().value() + period.value() - 1) / period.value();
+  ac_sync_cycles = left < UINT_MAX ? (unsigned) left : UINT_MAX;
+}
+
+/// Public method that flushes the pending cycles, syncing with the SystemC
+/// kernel if the quantum is over.
+void ac_module::sync_cycles() {
+  flush_cycles();
+  if (ac_qk.need_sync()) {
+    ac_qk.sync();
+    flush_cycles();
+  }
 }
 
@@ -0,0 +1,88 @@
+/**
+ * @file      ac_plugin.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Instrumentation plugins loaded by simulators at run time.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <dlfcn.h>
+#include <stdlib.h>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_plugin.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+ac_plugin_host::ac_plugin_host() :
+  instrument_every(false), any(false), model(""), instr_table(0),
+  instr_count(0) {}
+
+void ac_plugin_host::load(const std::list<std::string>& specs, const char* model,
+                          const ac_instr_info* table, unsigned count) {
+  this->model = model;
+  instr_table = table;
+  instr_count = count;
+
+  for (std::list<std::string>::const_iterator s = specs.begin(); s != specs.end(); s++) {
+    size_t comma = s->find(',');
+    std::string file = s->substr(0, comma);
+    std::string args = comma == std::string::npos ? "" : s->substr(comma + 1);
+    ac_plugin_install_t install;
+    void* handle;
+
+    // Plugins resolve the host methods against the simulator itself
+    handle = dlopen(file.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if (!handle) {
+      AC_ERROR("Could not load plugin " << file << ": " << dlerror());
+      exit(EXIT_FAILURE);
+    }
+    install = (ac_plugin_install_t) dlsym(handle, AC_PLUGIN_INSTALL);
+    if (!install) {
+      AC_ERROR("Plugin " << file << " does not export " << AC_PLUGIN_INSTALL << ".");
+      exit(EXIT_FAILURE);
+    }
+    if (install(this, args.c_str()) != 0) {
+      AC_ERROR("Plugin " << file << " failed to install.");
+      exit(EXIT_FAILURE);
+    }
+    any = true;
+  }
+}
+
+void ac_plugin_host::finish() {
+  hook_list<exit_cb> hooks;
+
+  hooks.swap(exit_hooks);
+  for (size_t i = 0; i < hooks.size(); i++)
+    hooks[i].first(hooks[i].second);
+}
@@ -307,6 +307,62 @@ ac_decoder* ac_decoder::AddToDecoder(ac_decoder* decoder, ac_dec_instr* instruct
   return base;
 }
 
+// Caches the field checked by each node, so decoding does not search for it
+static void ResolveFields(ac_decoder* d, ac_dec_field* fields)
+{
+  while (d) {
+    d -> field = fields -> FindDecField(d -> check -> id);
+    if (d -> found) {
+      // Operand list, linked through subcheck
+      for (ac_decoder* op = d -> subcheck; op; op = op -> subcheck)
+        op -> field = fields -> FindDecField(op -> check -> id);
+    }
+    else
+      ResolveFields(d -> subcheck, fields);
+    d = d -> next;
+  }
+}
+
+ac_dec_table* ac_dec_table::Build(ac_decoder* chain)
+{
+  ac_dec_table *t;
+  ac_decoder *d;
+
+  if (!chain)
+    return NULL;
+  t = new ac_dec_table();
+
+  // Irregular chain (more than one field checked) or too wide field
+  for (d = chain; d; d = d -> next)
+    if (d -> check -> id != chain -> check -> id)
+      break;
+  if (d || chain -> field -> size > AC_DEC_TABLE_MAX_BITS) {
+    t -> fallback = chain;
+    return t;
+  }
+
+  t -> field = chain -> field;
+  t -> mask = (1U << t -> field -> size) - 1;
+  t -> entries = new ac_dec_table_entry[t -> mask + 1]();
+
+  for (d = chain; d; d = d -> next) {
+    unsigned index = d -> check -> value & t -> mask;
+    long long value = index;
+
+    // Values the field can not hold never match
+    if (t -> field -> sign && t -> field -> size && (index >> (t -> field -> size - 1)))
+      value -= 1LL << t -> field -> size;
+    if (value != d -> check -> value)
+      continue;
+
+    t -> entries[index].node = d;
+    if (!d -> found)
+      t -> entries[index].sub = Build(d -> subcheck);
+  }
+
+  return t;
+}
+
 // ac_decoder_full static method, or constructor? :-D
 ac_decoder_full *ac_decoder_full::CreateDecoder(ac_dec_format *formats, ac_dec_instr *instructions, ac_dec_prog_source* source)
 {
@@ -351,33 +407,29 @@ ac_decoder_full *ac_decoder_full::CreateDecoder(ac_dec_format *formats, ac_dec_i
   full -> instructions = instructions;
   full -> nFields = nFields;
   full -> prog_source = source;
-  
+  full -> values = new unsigned[nFields];
+
+  ResolveFields(dec, allFields);
+  full -> table = ac_dec_table::Build(dec);
+
   return full;
 }
 
-unsigned* ac_decoder_full::Decode(unsigned char *buffer, int quant)
+ac_decoder* ac_decoder_full::DecodeTree(ac_decoder* chain, unsigned char *buffer, int* quant,
+                                        ac_dec_prog_source* source, unsigned* values)
 {
-  ac_decoder_full *decoder = this;
-  ac_decoder *d = decoder -> decoder;
+  ac_decoder *d = chain;
   ac_dec_field *field = 0;
   long long field_value = 0;
-  ac_dec_instr *instruction = NULL;
-  //char byte;
-  static unsigned *fields = 0;
 
   ac_decoder *chosenPath[64]; // usar uma constante = MAX_DECODER_DEPTH
   int chosenPathPos = 0;
   chosenPath[chosenPathPos] = d;
 
- //!Allocate the first time only
-  if (!fields) {
-    fields = new unsigned[decoder -> nFields];
-  }
-
   while (d) {
     if (!field) {
-      field = decoder->fields->FindDecField(d -> check -> id);
-      field_value = decoder->prog_source->GetBits(buffer, &quant, field -> first_bit, field -> size, field -> sign);
+      field = d -> field;
+      field_value = source->GetBits(buffer, quant, field -> first_bit, field -> size, field -> sign);
     }
 
     //fprintf(stderr, "Decoder - FieldName: %s ValueRequired: %d ValueFound: %d\n",
@@ -386,13 +438,12 @@ unsigned* ac_decoder_full::Decode(unsigned char *buffer, int quant)
     if (field_value == d -> check -> value) {
       if (d -> found) {
         //fprintf(stderr, "Instruction %s has been found.\n", d -> found -> name);
-        fields[d->check->id] = field_value;
-        instruction = d->found;
-        break;
+        values[d->check->id] = field_value;
+        return d;
       } else {
         //fprintf(stderr, "Following d -> subcheck branch in the decoder tree. \n");
         chosenPath[++chosenPathPos] = d -> subcheck;
-        fields[d->check->id] = field_value;
+        values[d->check->id] = field_value;
         d = d -> subcheck;
         field = 0;
       }
@@ -414,20 +465,54 @@ unsigned* ac_decoder_full::Decode(unsigned char *buffer, int quant)
     }
   }
 
-  /* If found, extract operands from instruction */
-  if (instruction != NULL) {
-    d = d->subcheck;
-    while (d) {
-      field = decoder->fields->FindDecField(d -> check -> id);
-      field_value = decoder->prog_source->GetBits(buffer, &quant, field -> first_bit, field -> size, field -> sign);
-      fields[d->check->id] = field_value;
-      d = d->subcheck;
+  return NULL;
+}
+
+unsigned* ac_decoder_full::Decode(unsigned char *buffer, int quant)
+{
+  return Decode(buffer, quant, prog_source, values);
+}
+
+unsigned* ac_decoder_full::Decode(unsigned char *buffer, int quant,
+                                  ac_dec_prog_source* source, unsigned* values)
+{
+  ac_dec_table *t = table;
+  ac_decoder *d = NULL;
+  ac_dec_field *field;
+  long long field_value;
+
+  // Follow the tables while the encoding is regular, one field per level
+  while (t) {
+    if (!t -> field) {
+      d = DecodeTree(t -> fallback, buffer, &quant, source, values);
+      break;
     }
-    fields[0] = instruction->id;
-    return fields;
+    field = t -> field;
+    field_value = source->GetBits(buffer, &quant, field -> first_bit, field -> size, field -> sign);
+    ac_dec_table_entry& e = t -> entries[field_value & t -> mask];
+    if (!e.node)
+      return NULL;
+    values[field -> id] = field_value;
+    if (e.node -> found) {
+      d = e.node;
+      break;
+    }
+    t = e.sub;
   }
 
-  return NULL;
+  /* If found, extract operands from instruction */
+  if (d == NULL)
+    return NULL;
+
+  ac_dec_instr *instruction = d -> found;
+  d = d->subcheck;
+  while (d) {
+    field = d -> field;
+    values[d->check->id] = source->GetBits(buffer, &quant, field -> first_bit, field -> size, field -> sign);
+    d = d->subcheck;
+  }
+  values[0] = instruction->id;
+  return values;
 }
 
 // ac_dec_format method?
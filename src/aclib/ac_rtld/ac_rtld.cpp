@@ -65,7 +65,7 @@ namespace ac_dynlink {
     link_node *p = root;
     
     while (p != NULL) {
-      p->load_needed(&mem_map, mem, mem_size);
+      p->load_needed(&mem_map, mem, mem_size, code_segments);
       p = p->get_next();
     }
   }
@@ -168,6 +168,7 @@ namespace ac_dynlink {
     unsigned *initvec, initvecn;
     this->word_size = word_size;
     this->glibc = true;
+    code_segments.clear();
     
     if (rtld_config.is_config_loaded())
       root = new link_node(NULL, &rtld_config);
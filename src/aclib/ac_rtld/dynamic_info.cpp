@@ -190,7 +190,7 @@ namespace ac_dynlink {
 
   /* Load needed shared libraries, as indicated in DT_NEEDED tags */
   void dynamic_info::load_needed (memmap *mem_map, unsigned char *mem, link_node * l_node, Elf32_Word mem_size,
-				  version_needed * verneed)
+				  version_needed * verneed, std::vector<std::pair<unsigned, unsigned> >& code_segments)
   {
     unsigned int i;
     unsigned char *soname;
@@ -216,7 +216,8 @@ namespace ac_dynlink {
           if (p)
             continue; /* library is already loaded */
           
-          mem_map->add_region(load_addr, load_library(load_addr, mem, soname, dyn_addr, dyn_size, mem_size));
+          mem_map->add_region(load_addr, load_library(load_addr, mem, soname, dyn_addr, dyn_size, mem_size,
+                                                           code_segments));
           
           if (dyn_addr == 0 || dyn_size == 0) {
             AC_ERROR("Run-time dynamic linker: Could not find DYNAMIC segment of library \"" << soname << "\".\n");
@@ -237,9 +238,11 @@ old and can't be used (version mismatch).\n");
 
     /* Loads the library "soname" into app.memory "mem". Return the size occupied by the library,
        loaded at address "load_addr". If a DYNAMIC segment is present, "dyn_addr" and "dyn_size"
-       by reference parameters are filled with its address and size.*/
+       by reference parameters are filled with its address and size. Its executable segments
+       are added to "code_segments".*/
   Elf32_Word dynamic_info::load_library (Elf32_Addr load_addr, unsigned char *mem, unsigned char *soname,
-					 Elf32_Addr& dyn_addr, Elf32_Word& dyn_size, Elf32_Word mem_size) {
+					 Elf32_Addr& dyn_addr, Elf32_Word& dyn_size, Elf32_Word mem_size,
+					 std::vector<std::pair<unsigned, unsigned> >& code_segments) {
     Elf32_Ehdr    ehdr;
     Elf32_Phdr    phdr;
     int           fd;
@@ -318,6 +321,9 @@ old and can't be used (version mismatch).\n");
             exit(EXIT_FAILURE);
           }
         memset(mem + p_vaddr + load_addr + p_filesz, 0, p_memsz - p_filesz);
+
+	if (convert_endian(4, phdr.p_flags, match_endian) & PF_X)
+	  code_segments.push_back(std::make_pair(load_addr + p_vaddr, load_addr + p_vaddr + p_memsz));
 	
 	break;
       }
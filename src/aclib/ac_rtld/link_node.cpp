@@ -371,10 +371,11 @@ namespace ac_dynlink {
     return new_node;
   }
   
-  void link_node::load_needed (memmap *mem_map, unsigned char *mem, Elf32_Word mem_size) 
+  void link_node::load_needed (memmap *mem_map, unsigned char *mem, Elf32_Word mem_size,
+                               std::vector<std::pair<unsigned, unsigned> >& code_segments) 
   {
     if (!needed_is_loaded) {
-      dyn_info.load_needed(mem_map, mem, this, mem_size, dyn_table.get_verneed());
+      dyn_info.load_needed(mem_map, mem, this, mem_size, dyn_table.get_verneed(), code_segments);
       needed_is_loaded = 1;
     }
   }
@@ -371,4 +371,32 @@ namespace ac_dynlink {
     return addr;
     
   }
+
+  void memmap::get_state(std::vector<Elf32_Addr> &state) {
+    state.clear();
+    state.push_back(brkaddr);
+    state.push_back(newbrkaddr);
+    for (memmap_node *aux = list; aux != NULL; aux = aux->get_next()) {
+      state.push_back(aux->get_addr());
+      state.push_back(aux->get_status());
+    }
+  }
+
+  void memmap::set_state(const Elf32_Addr *state, size_t count) {
+    memmap_node *last = NULL;
+
+    free_memmap();
+    brkaddr = state[0];
+    newbrkaddr = state[1];
+    for (size_t i = 2; i + 1 < count; i += 2) {
+      memmap_node *node = new memmap_node(NULL, (memmap_status) state[i + 1], state[i]);
+      if (last == NULL)
+        list = node;
+      else
+        last->set_next(node);
+      last = node;
+    }
+    if (list == NULL)
+      list = new memmap_node(NULL, MS_FREE, 0);
+  }
 }
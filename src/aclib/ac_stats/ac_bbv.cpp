@@ -0,0 +1,141 @@
+/**
+ * @file      ac_bbv.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Basic block vectors per interval, in SimPoint input format.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <string>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_bbv.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Method definitions.
+
+ac_bbv::ac_bbv() :
+  next_pc(0),
+  out_(NULL),
+  interval_(0),
+  next_end_(~0ULL),
+  start_(0),
+  current_(0)
+{}
+
+ac_bbv::~ac_bbv()
+{
+  if (out_)
+    fclose(out_);
+}
+
+void ac_bbv::open(const char* proc, unsigned long long interval, const char* file)
+{
+  std::string name = ac_output_name(file ? file : std::string("bb.out.") + proc);
+
+  if (!interval || out_)
+    return;
+
+  if (!(out_ = fopen(name.c_str(), "w"))) {
+    fprintf(stderr, "ArchC: Could not open basic block vector file %s\n", name.c_str());
+    return;
+  }
+
+  interval_ = interval;
+  next_end_ = interval;
+}
+
+void ac_bbv::charge(unsigned long long count)
+{
+  if (!current_)
+    return;
+
+  if (!counts_[current_ - 1])
+    run_.push_back(current_);
+  counts_[current_ - 1] += count - start_;
+}
+
+void ac_bbv::write()
+{
+  // SimPoint does not take empty vectors
+  if (!run_.empty()) {
+    fputc('T', out_);
+    for (size_t i = 0; i < run_.size(); i++) {
+      fprintf(out_, ":%u:%llu ", run_[i], counts_[run_[i] - 1]);
+      counts_[run_[i] - 1] = 0;
+    }
+    fputc('\n', out_);
+    run_.clear();
+  }
+}
+
+void ac_bbv::enter(unsigned& id, uint32_t pc, unsigned long long count)
+{
+  if (!out_)
+    return;
+
+  charge(count);
+  if (count > next_end_) {
+    write();
+    // a long block may cross several interval ends
+    while (next_end_ < count)
+      next_end_ += interval_;
+  }
+
+  // entries of a decode cache saved by another run hold other numbers
+  if (!id || id > pcs_.size() || pcs_[id - 1] != pc) {
+    std::map<uint32_t, unsigned>::iterator b = ids_.find(pc);
+    if (b == ids_.end()) {
+      pcs_.push_back(pc);
+      counts_.push_back(0);
+      b = ids_.insert(std::make_pair(pc, (unsigned) pcs_.size())).first;
+    }
+    id = b->second;
+  }
+
+  current_ = id;
+  start_ = count;
+}
+
+void ac_bbv::close(unsigned long long count)
+{
+  if (!out_)
+    return;
+
+  // the last block runs up to instruction count, included
+  charge(count + 1);
+  write();
+  fclose(out_);
+  out_ = NULL;
+  current_ = 0;
+}
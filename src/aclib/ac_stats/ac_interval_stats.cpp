@@ -0,0 +1,148 @@
+/**
+ * @file      ac_interval_stats.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Time series of processor counters, one row per interval.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_interval_stats.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Method definitions.
+
+ac_interval_stats::ac_interval_stats() :
+  next_instr(~0ULL),
+  next_ns(HUGE_VAL),
+  out_(NULL),
+  binary_(false),
+  in_ns_(false),
+  period_(0)
+{}
+
+ac_interval_stats::~ac_interval_stats()
+{
+  close();
+}
+
+void ac_interval_stats::open(const char* proc, const char* const* columns,
+                             unsigned count, unsigned long long period,
+                             bool in_ns, const char* file)
+{
+  std::string name = ac_output_name(file ? file : std::string(proc) + "_intervals.csv");
+
+  if (!period || out_)
+    return;
+
+  binary_ = name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0;
+  if (!(out_ = fopen(name.c_str(), binary_ ? "wb" : "w"))) {
+    fprintf(stderr, "ArchC: Could not open interval statistics file %s\n", name.c_str());
+    return;
+  }
+
+  period_ = period;
+  in_ns_ = in_ns;
+  columns_.assign(columns, columns + count);
+  current_.assign(count, 0);
+  last_.assign(count, 0);
+  line_.assign(count + 2, 0);
+
+  if (binary_) {
+    uint32_t n = count + 2;
+
+    fwrite(AC_INTERVAL_MAGIC, 1, 8, out_);
+    fwrite(&n, sizeof(n), 1, out_);
+    fwrite("instructions", 1, sizeof("instructions"), out_);
+    fwrite("time_ns", 1, sizeof("time_ns"), out_);
+    for (unsigned i = 0; i < count; i++)
+      fwrite(columns[i], 1, strlen(columns[i]) + 1, out_);
+  }
+  else {
+    fprintf(out_, "instructions,time_ns");
+    for (unsigned i = 0; i < count; i++)
+      fprintf(out_, ",%s", columns[i]);
+    fprintf(out_, "\n");
+  }
+
+  if (in_ns)
+    next_ns = (double) period;
+  else
+    next_instr = period;
+}
+
+void ac_interval_stats::sample(unsigned long long instructions, double ns)
+{
+  if (!out_)
+    return;
+
+  // the last interval may end where the previous one did
+  if (instructions != line_[0]) {
+    line_[0] = instructions;
+    line_[1] = (unsigned long long) ns;
+    for (size_t i = 0; i < current_.size(); i++)
+      line_[i + 2] = current_[i] - last_[i];
+    last_.swap(current_);
+
+    if (binary_)
+      fwrite(&line_[0], sizeof(line_[0]), line_.size(), out_);
+    else {
+      for (size_t i = 0; i < line_.size(); i++)
+        fprintf(out_, i ? ",%llu" : "%llu", line_[i]);
+      fprintf(out_, "\n");
+    }
+  }
+
+  // a long instruction or quantum may cross several interval ends
+  if (in_ns_)
+    while (next_ns <= ns)
+      next_ns += period_;
+  else
+    while (next_instr <= instructions)
+      next_instr += period_;
+}
+
+void ac_interval_stats::close()
+{
+  if (!out_)
+    return;
+
+  fclose(out_);
+  out_ = NULL;
+  next_instr = ~0ULL;
+  next_ns = HUGE_VAL;
+}
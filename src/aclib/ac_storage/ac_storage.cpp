@@ -57,6 +57,10 @@ uint32_t ac_storage::get_size() const {
   return size;
 }
 
+uint8_t* ac_storage::get_host_ptr() {
+  return data.ptr8;
+}
+
 void ac_storage::read(ac_ptr buf, uint32_t address,
 		      int wordsize) {
   switch (wordsize) {
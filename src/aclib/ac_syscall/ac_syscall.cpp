@@ -30,6 +30,9 @@
  *
  */
 
+#include <unistd.h>
+#include "ac_guest_files.H"
+
 #define NEWLIB_O_RDONLY          0x0000
 #define NEWLIB_O_WRONLY          0x0001
 #define NEWLIB_O_RDWR            0x0002
@@ -76,3 +79,38 @@ void correct_flags( int* val )
 
   *val = flags;
 }
+
+std::map<int, ac_guest_file> ac_guest_files;
+
+void ac_guest_file_open(int fd, const char* path, int flags, int mode)
+{
+  ac_guest_file& file = ac_guest_files[fd];
+
+  file.path = path;
+  file.flags = flags;
+  file.mode = mode;
+  file.dup_of = -1;
+}
+
+void ac_guest_file_close(int fd)
+{
+  ac_guest_files.erase(fd);
+}
+
+void ac_guest_file_dup(int fd, int newfd)
+{
+  std::map<int, ac_guest_file>::iterator file = ac_guest_files.find(fd);
+
+  if (fd == newfd)
+    return;
+  if (file != ac_guest_files.end())
+    ac_guest_files[newfd] = file->second;
+  else if (fd == STDIN_FILENO || fd == STDOUT_FILENO || fd == STDERR_FILENO) {
+    ac_guest_file& dup = ac_guest_files[newfd];
+    dup.path.clear();
+    dup.flags = dup.mode = 0;
+    dup.dup_of = fd;
+  }
+  else
+    ac_guest_files.erase(newfd);
+}
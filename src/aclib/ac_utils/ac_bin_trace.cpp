@@ -0,0 +1,146 @@
+/**
+ * @file      ac_bin_trace.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Binary instruction trace written by a background thread.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_bin_trace.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+ac_bin_trace_t ac_bin_trace;
+
+static void close_bin_trace() {
+  ac_bin_trace.close();
+}
+
+// Appends value in unsigned LEB128 to p
+static inline unsigned char* put_leb128(unsigned char* p, uint64_t value) {
+  while (value >= 0x80) {
+    *p++ = (unsigned char) (value | 0x80);
+    value >>= 7;
+  }
+  *p++ = (unsigned char) value;
+  return p;
+}
+
+static inline uint64_t zigzag(uint32_t to, uint32_t from) {
+  int64_t delta = (int64_t) to - from;
+  return delta < 0 ? ((uint64_t) -delta << 1) - 1 : (uint64_t) delta << 1;
+}
+
+ac_bin_trace_t::ac_bin_trace_t() :
+  ring(0), head(0), room(0), published(0), tail(0), done(false), file(0),
+  on(false), mem_on(false) {}
+
+ac_bin_trace_t::~ac_bin_trace_t() {
+  close();
+}
+
+bool ac_bin_trace_t::open(const char* name, bool mem) {
+  if (file)
+    return false;
+  file = fopen(ac_output_name(name).c_str(), "wb");
+  if (!file)
+    return false;
+  fwrite(AC_BIN_TRACE_MAGIC, 1, AC_BIN_TRACE_MAGIC_SIZE, file);
+
+  ring = new record[RING_SIZE];
+  room = RING_SIZE;
+  writer = std::thread(&ac_bin_trace_t::run, this);
+  atexit(close_bin_trace);
+
+  on = true;
+  mem_on = mem;
+  return true;
+}
+
+void ac_bin_trace_t::close() {
+  if (!writer.joinable())
+    return;
+  on = mem_on = false;
+  done.store(true, std::memory_order_release);
+  writer.join();
+  fclose(file);
+  file = 0;
+  delete[] ring;
+  ring = 0;
+}
+
+// Waits until the writer frees some records
+void ac_bin_trace_t::wait_room() {
+  while ((room = RING_SIZE - (head - tail.load(std::memory_order_acquire))) == 0)
+    std::this_thread::yield();
+}
+
+// Writer thread: encodes the records published so far and writes them
+void ac_bin_trace_t::run() {
+  std::vector<unsigned char> buffer(RING_SIZE * 16);
+  uint32_t last_pc = 0, last_addr = 0;
+  size_t t = 0;
+
+  for (;;) {
+    bool finished = done.load(std::memory_order_acquire);
+    size_t h = published.load(std::memory_order_acquire);
+
+    if (h == t) {
+      if (finished)
+        break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+
+    unsigned char* p = &buffer[0];
+    for (; t != h; t++) {
+      const record& r = ring[t & (RING_SIZE - 1)];
+
+      if (r.kind == AC_BIN_TRACE_INSTR) {
+        p = put_leb128(p, (zigzag(r.value, last_pc) << 2) | AC_BIN_TRACE_INSTR);
+        last_pc = r.value;
+      }
+      else {
+        p = put_leb128(p, (zigzag(r.value, last_addr) << 2) | r.kind);
+        last_addr = r.value;
+      }
+      p = put_leb128(p, r.arg);
+    }
+    tail.store(t, std::memory_order_release);
+    fwrite(&buffer[0], 1, p - &buffer[0], file);
+  }
+}
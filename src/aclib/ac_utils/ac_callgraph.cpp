@@ -0,0 +1,213 @@
+/**
+ * @file      ac_callgraph.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Call graph profiler of the guest program.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdio.h>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_callgraph.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// Deepest shadow stack; calls beyond it are charged to the caller.
+static const size_t max_depth = 4096;
+
+ac_callgraph::ac_callgraph() : last(0), on(false) {}
+
+ac_callgraph::~ac_callgraph() {
+  close(last);
+}
+
+void ac_callgraph::open(const char* name) {
+  extern char* appfilename;
+
+  if (on)
+    return;
+  if (!symtab.load(appfilename))
+    fprintf(stderr, "ArchC: No function symbols in %s, call graph will not name them\n",
+            appfilename ? appfilename : "the program");
+
+  self.assign(symtab.all().size() + 1, 0);
+  edges.clear();
+  nodes.clear();
+  node_ids.clear();
+  stack.clear();
+  stack.reserve(max_depth);
+  last = 0;
+  file = ac_output_name(std::string("callgrind.out.") + name);
+  on = true;
+}
+
+unsigned ac_callgraph::function(uint32_t pc) const {
+  const ac_symtab::symbol* sym = symtab.find(pc);
+  return sym ? symtab.index(sym) : symtab.all().size();
+}
+
+const char* ac_callgraph::function_name(unsigned func) const {
+  return func < symtab.all().size() ? symtab.all()[func].name.c_str() : "[unknown]";
+}
+
+unsigned ac_callgraph::node(unsigned parent, unsigned func) {
+  std::pair<std::map<std::pair<unsigned, unsigned>, unsigned>::iterator, bool> n =
+    node_ids.insert(std::make_pair(std::make_pair(parent, func), (unsigned) nodes.size()));
+
+  if (n.second)
+    nodes.push_back(std::make_pair(parent, func));
+  return n.first->second;
+}
+
+std::string ac_callgraph::stack_name(unsigned id) const {
+  std::string name;
+
+  for (; id < nodes.size(); id = nodes[id].first)
+    name = function_name(nodes[id].second) + (name.empty() ? "" : ";" + name);
+  return name;
+}
+
+void ac_callgraph::call(unsigned func, uint32_t ret, unsigned long long count) {
+  if (stack.size() >= max_depth)
+    return;
+
+  edge& e = edges[std::make_pair(stack.back().func, func)];
+  e.calls++;
+
+  frame f = { func, ret, count, &e, node(stack.back().node, func) };
+  stack.push_back(f);
+}
+
+void ac_callgraph::pop(unsigned long long count) {
+  frame& f = stack.back();
+  f.from->inclusive += count - f.entry;
+  stack.pop_back();
+}
+
+void ac_callgraph::transfer(uint32_t pc, uint32_t next, uint32_t ret, unsigned long long count) {
+  if (stack.empty()) {
+    // the root frame is never returned from
+    frame root = { function(pc), 0, 0, NULL, node(~0u, function(pc)) };
+    stack.push_back(root);
+  }
+
+  self[stack.back().func] += count - last;
+  last = count;
+
+  if (stack.size() > 1 && next == stack.back().ret) {
+    pop(count);
+    return;
+  }
+
+  const ac_symtab::symbol* sym = symtab.find(next);
+  if (sym && sym->start == next) {
+    call(symtab.index(sym), ret, count);
+    return;
+  }
+
+  unsigned func = sym ? symtab.index(sym) : symtab.all().size();
+  if (func == stack.back().func || !sym)
+    return;
+
+  // longjmp and the like return through several frames at once
+  for (size_t i = stack.size() - 1; i-- > 1; ) {
+    if (stack[i].ret == next) {
+      while (stack.size() > i)
+        pop(count);
+      return;
+    }
+  }
+
+  // a jump into another function: tail call keeping the return address
+  if (stack.size() > 1) {
+    uint32_t tail_ret = stack.back().ret;
+    pop(count);
+    call(func, tail_ret, count);
+  }
+  else {
+    stack.back().func = func;
+    stack.back().node = node(~0u, func);
+  }
+}
+
+void ac_callgraph::close(unsigned long long count) {
+  extern char* appfilename;
+
+  if (!on)
+    return;
+  on = false;
+
+  unsigned long long total = 0;
+  if (!stack.empty()) {
+    self[stack.back().func] += count - last;
+    while (stack.size() > 1)
+      pop(count);
+  }
+  for (size_t i = 0; i < self.size(); i++)
+    total += self[i];
+
+  FILE* out = fopen(file.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "ArchC: Could not write call graph %s\n", file.c_str());
+    return;
+  }
+
+  fprintf(out, "# callgrind format\n");
+  fprintf(out, "version: 1\n");
+  fprintf(out, "creator: ArchC\n");
+  fprintf(out, "cmd: %s\n", appfilename ? appfilename : "");
+  fprintf(out, "positions: line\n");
+  fprintf(out, "events: Ir\n");
+  fprintf(out, "summary: %llu\n", total);
+
+  // edges are sorted by caller, so each function is followed by its calls
+  edge_map::const_iterator e = edges.begin();
+  for (unsigned func = 0; func < self.size(); func++) {
+    if (!self[func] && (e == edges.end() || e->first.first != func))
+      continue;
+
+    fprintf(out, "\nfn=%s\n", function_name(func));
+    fprintf(out, "0 %llu\n", self[func]);
+    for (; e != edges.end() && e->first.first == func; ++e) {
+      unsigned callee = e->first.second;
+      fprintf(out, "cfn=%s\n", function_name(callee));
+      fprintf(out, "calls=%llu 0\n", e->second.calls);
+      fprintf(out, "0 %llu\n", e->second.inclusive);
+    }
+  }
+  fclose(out);
+
+  fprintf(stderr, "ArchC: Call graph written to %s\n", file.c_str());
+  stack.clear();
+  edges.clear();
+}
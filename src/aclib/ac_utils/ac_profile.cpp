@@ -0,0 +1,215 @@
+/**
+ * @file      ac_profile.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Sampling profiler of the guest program counter.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+
+// SystemC includes
+
+// ArchC includes
+#include "ac_profile.H"
+#include "ac_symtab.H"
+#include "ac_utils.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+std::vector<ac_profile*> ac_profile::instances;
+
+/// Largest span of code, in bytes, counted in the flat array.
+static const uint32_t max_code_span = 64 << 20;
+
+namespace {
+
+struct function_samples {
+  std::string name;
+  unsigned long long samples;
+
+  bool operator<(const function_samples& other) const {
+    return samples > other.samples || (samples == other.samples && name < other.name);
+  }
+};
+
+} // file scope
+
+ac_profile::ac_profile() :
+  countdown(0), period(1), seed(2463534242u), base(0), callgraph(0), on(false) {}
+
+ac_profile::~ac_profile() {
+  close();
+  instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+}
+
+void ac_profile::close_all() {
+  for (size_t i = 0; i < instances.size(); i++)
+    instances[i]->close();
+}
+
+void ac_profile::open(const char* name,
+                      const std::vector<std::pair<unsigned, unsigned> >& code_segments,
+                      unsigned period, ac_callgraph* callgraph) {
+  extern char* appfilename;
+  uint32_t first = 0xffffffff, last = 0;
+
+  if (on)
+    return;
+  for (size_t i = 0; i < code_segments.size(); i++) {
+    first = std::min(first, (uint32_t) code_segments[i].first);
+    last = std::max(last, (uint32_t) code_segments[i].second);
+  }
+  if (first < last && last - first <= max_code_span) {
+    base = first & ~1u;
+    counts.assign((last - base + 1) / 2, 0);
+  }
+
+  std::string app(appfilename ? appfilename : "");
+  prefix = std::string(name) + "_" + app.substr(app.find_last_of("\\/") + 1);
+
+  this->period = period ? period : 1;
+  this->callgraph = callgraph;
+  countdown = 1;
+  on = true;
+  static bool registered = false;
+  if (!registered)
+    atexit(close_all);
+  registered = true;
+  instances.push_back(this);
+}
+
+void ac_profile::sample(uint32_t pc) {
+  if (!on) {
+    countdown = 0xffffffff;
+    return;
+  }
+
+  uint32_t slot = (pc - base) / 2;
+  if (slot < counts.size())
+    counts[slot]++;
+  else
+    others[pc]++;
+  if (callgraph)
+    stacks[callgraph->stack_id(pc)]++;
+
+  // xorshift32; the next sample is 1 to 2 * period - 1 instructions away
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  countdown = 1 + seed % (2 * period - 1);
+}
+
+void ac_profile::close() {
+  extern char* appfilename;
+
+  if (!on)
+    return;
+  on = false;
+
+  ac_symtab symtab;
+  symtab.load(appfilename);
+
+  // samples per function, then of pcs out of every function
+  std::vector<unsigned long long> per_symbol(symtab.all().size(), 0);
+  std::map<uint32_t, unsigned long long> unknown;
+  unsigned long long total = 0;
+
+  for (size_t i = 0; i < counts.size(); i++)
+    if (counts[i])
+      others[base + 2 * i] += counts[i];
+  counts.clear();
+
+  for (std::map<uint32_t, uint32_t>::const_iterator s = others.begin(); s != others.end(); ++s) {
+    const ac_symtab::symbol* sym = symtab.find(s->first);
+    if (sym)
+      per_symbol[symtab.index(sym)] += s->second;
+    else
+      unknown[s->first] += s->second;
+    total += s->second;
+  }
+  others.clear();
+
+  std::vector<function_samples> functions;
+  for (size_t i = 0; i < per_symbol.size(); i++) {
+    if (per_symbol[i]) {
+      function_samples f = { symtab.all()[i].name, per_symbol[i] };
+      functions.push_back(f);
+    }
+  }
+  for (std::map<uint32_t, unsigned long long>::const_iterator u = unknown.begin(); u != unknown.end(); ++u) {
+    char name[16];
+    snprintf(name, sizeof(name), "0x%x", u->first);
+    function_samples f = { name, u->second };
+    functions.push_back(f);
+  }
+  std::sort(functions.begin(), functions.end());
+
+  std::string flat_name = ac_output_name(prefix + ".prof");
+  std::string folded_name = ac_output_name(prefix + ".folded");
+  FILE* flat = fopen(flat_name.c_str(), "w");
+  FILE* folded = fopen(folded_name.c_str(), "w");
+
+  if (flat) {
+    unsigned long long cumulative = 0;
+
+    fprintf(flat, "Flat profile:\n\n");
+    fprintf(flat, "Each sample counts as %u instructions (on average).\n", period);
+    fprintf(flat, "%llu samples, about %llu instructions.\n\n", total, total * period);
+    fprintf(flat, "  %%     cumulative       self\n");
+    fprintf(flat, " instr  instructions  instructions  samples  name\n");
+    for (size_t i = 0; i < functions.size(); i++) {
+      cumulative += functions[i].samples;
+      fprintf(flat, "%6.2f %13llu %13llu %8llu  %s\n",
+              total ? 100.0 * functions[i].samples / total : 0.0,
+              cumulative * period, functions[i].samples * period,
+              functions[i].samples, functions[i].name.c_str());
+    }
+    fclose(flat);
+  }
+
+  if (folded) {
+    for (std::map<unsigned, uint32_t>::const_iterator s = stacks.begin(); s != stacks.end(); ++s)
+      fprintf(folded, "%s %u\n", callgraph->stack_name(s->first).c_str(), s->second);
+    if (!callgraph)
+      for (size_t i = 0; i < functions.size(); i++)
+        fprintf(folded, "%s %llu\n", functions[i].name.c_str(), functions[i].samples);
+    fclose(folded);
+  }
+  stacks.clear();
+
+  if (flat && folded)
+    fprintf(stderr, "ArchC: Profile written to %s and %s\n",
+            flat_name.c_str(), folded_name.c_str());
+  else
+    fprintf(stderr, "ArchC: Could not write profile %s\n", flat_name.c_str());
+}
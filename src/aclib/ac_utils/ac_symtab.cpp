@@ -0,0 +1,163 @@
+/**
+ * @file      ac_symtab.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br/
+ *
+ * @version   1.0
+ *
+ * @brief     Function symbols of the guest program, for profiles.
+ *
+ * @attention Copyright (C) 2002-2006 --- The ArchC Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Standard includes
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// SystemC includes
+
+// ArchC includes
+#include "elf32-tiny.h"
+#include "ac_symtab.H"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Reads fields of an ELF file whose byte order may differ from the host's
+struct elf_reader {
+  FILE* file;
+  bool swap;
+
+  uint32_t get(uint32_t v) const {
+    return swap ? (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24) : v;
+  }
+  uint16_t get(uint16_t v) const {
+    return swap ? (uint16_t) ((v >> 8) | (v << 8)) : v;
+  }
+  bool read(long offset, void* data, size_t size) const {
+    return fseek(file, offset, SEEK_SET) == 0 && fread(data, 1, size, file) == size;
+  }
+};
+
+bool host_big_endian() {
+  const uint16_t one = 1;
+  return *(const unsigned char*) &one == 0;
+}
+
+} // file scope
+
+bool ac_symtab::load(const char* name) {
+  elf_reader elf;
+  Elf32_Ehdr ehdr;
+
+  symbols.clear();
+  if (!name || (elf.file = fopen(name, "rb")) == NULL)
+    return false;
+
+  if (!elf.read(0, &ehdr, sizeof(ehdr)) || strncmp((char*) ehdr.e_ident, ELFMAG, 4) ||
+      ehdr.e_ident[EI_CLASS] != ELFCLASS32) {
+    fclose(elf.file);
+    return false;
+  }
+  elf.swap = (ehdr.e_ident[EI_DATA] == ELFDATA2MSB) != host_big_endian();
+
+  uint32_t shoff = elf.get(ehdr.e_shoff);
+  uint16_t shentsize = elf.get(ehdr.e_shentsize);
+  uint16_t shnum = elf.get(ehdr.e_shnum);
+
+  // sections holding code
+  std::vector<bool> code(shnum, false);
+  for (unsigned i = 0; i < shnum; i++) {
+    Elf32_Shdr shdr;
+    code[i] = elf.read(shoff + i * shentsize, &shdr, sizeof(shdr)) &&
+              (elf.get(shdr.sh_flags) & SHF_EXECINSTR);
+  }
+
+  for (unsigned i = 0; i < shnum; i++) {
+    Elf32_Shdr shdr, strhdr;
+
+    if (!elf.read(shoff + i * shentsize, &shdr, sizeof(shdr)) ||
+        elf.get(shdr.sh_type) != SHT_SYMTAB ||
+        !elf.read(shoff + elf.get(shdr.sh_link) * shentsize, &strhdr, sizeof(strhdr)))
+      continue;
+
+    std::vector<char> strings(elf.get(strhdr.sh_size) + 1, '\0');
+    std::vector<Elf32_Sym> syms(elf.get(shdr.sh_size) / sizeof(Elf32_Sym));
+    if (!elf.read(elf.get(strhdr.sh_offset), &strings[0], strings.size() - 1) ||
+        (!syms.empty() && !elf.read(elf.get(shdr.sh_offset), &syms[0], syms.size() * sizeof(Elf32_Sym))))
+      continue;
+
+    for (size_t s = 0; s < syms.size(); s++) {
+      unsigned type = ELF32_ST_TYPE(syms[s].st_info);
+      uint32_t offset = elf.get(syms[s].st_name);
+      uint16_t section = elf.get(syms[s].st_shndx);
+      symbol sym;
+
+      // code labels of assembly sources have no type; skip the mapping
+      // symbols ($a, $t, $d) and local labels assemblers add
+      if ((type != STT_FUNC && type != STT_NOTYPE) || section >= shnum || !code[section] ||
+          offset >= strings.size() - 1 || strings[offset] == '\0' || strings[offset] == '$' ||
+          (type == STT_NOTYPE && ELF32_ST_BIND(syms[s].st_info) != STB_GLOBAL))
+        continue;
+
+      sym.start = elf.get(syms[s].st_value);
+      sym.end = sym.start + elf.get(syms[s].st_size);
+      sym.name = &strings[offset];
+      symbols.push_back(sym);
+    }
+  }
+  fclose(elf.file);
+
+  // keep one symbol per address, the first one with a size
+  std::stable_sort(symbols.begin(), symbols.end());
+  std::vector<symbol> unique;
+  for (size_t i = 0; i < symbols.size(); i++) {
+    if (!unique.empty() && unique.back().start == symbols[i].start) {
+      if (unique.back().end == unique.back().start)
+        unique.back() = symbols[i];
+      continue;
+    }
+    unique.push_back(symbols[i]);
+  }
+  symbols.swap(unique);
+
+  for (size_t i = 0; i < symbols.size(); i++)
+    if (symbols[i].end == symbols[i].start)
+      symbols[i].end = i + 1 < symbols.size() ? symbols[i + 1].start : 0xffffffff;
+
+  return !symbols.empty();
+}
+
+const ac_symtab::symbol* ac_symtab::find(uint32_t pc) const {
+  symbol key;
+  key.start = pc;
+
+  std::vector<symbol>::const_iterator it = std::upper_bound(symbols.begin(), symbols.end(), key);
+  if (it == symbols.begin())
+    return NULL;
+  --it;
+  return pc < it->end ? &*it : NULL;
+}
@@ -34,6 +34,8 @@
  *
  */
 
+#include <sstream>
+
 #include "ac_utils.H"
 
 #ifdef USE_GDB
@@ -61,6 +63,59 @@ bool ac_do_trace;
 //char *appfilename;
 std::map<std::string, std::ofstream*> ac_cache_traces;
 
+//Directory of the persistent decode cache files (--dec-cache-dir).
+char* ac_dec_cache_dir = NULL;
+
+//Instrumentation plugins to load, as <file>[,<args>] (--plugin).
+std::list<std::string> ac_plugins;
+
+//Data accesses are traced along with instructions (--bin-trace=mem).
+bool ac_bin_trace_mem = false;
+
+//Average number of instructions between pc samples (--profile-period).
+unsigned ac_profile_period = 100;
+
+//Average number of instructions between host cost samples (--host-cost-period).
+unsigned ac_host_cost_period = 1000;
+
+//Length of the interval statistics, in instructions or ns (--interval).
+unsigned long long ac_interval = 0;
+bool ac_interval_ns = false;
+
+//File of the interval statistics (--interval-file).
+char* ac_interval_file = NULL;
+
+//Start of the detailed regions, unset if 0, above 32 bits or NULL (--detail-*).
+unsigned long long ac_detail_at = 0;
+unsigned long long ac_detail_pc = ~0ULL;
+char* ac_detail_instr = NULL;
+
+//Instructions in each detailed region, 0 for up to the end (--detail-length).
+unsigned long long ac_detail_length = 0;
+
+//Instructions per basic block vector and per simulation point (--bbv-interval).
+unsigned long long ac_bbv_interval = 100000000;
+
+//File of the basic block vectors (--bbv-file).
+char* ac_bbv_file = NULL;
+
+//SimPoint file of the intervals run in detail (--simpoints).
+char* ac_simpoints = NULL;
+
+//Checkpoint triggers, unset if 0 or NULL, and file (--checkpoint-*).
+unsigned long long ac_checkpoint_at = 0;
+char* ac_checkpoint_syscall = NULL;
+char* ac_checkpoint_file = NULL;
+
+//Checkpoint to start from (--restore).
+char* ac_restore_file = NULL;
+
+//Unix socket of the fork server, unset if NULL (--fork-server).
+char* ac_fork_server_socket = NULL;
+
+//Job of the fork server run by this process, or 0 out of a job.
+unsigned ac_fork_job = 0;
+
 //Read model options before application
 void ac_init_opts( int ac, char* av[]){
 
@@ -81,6 +136,25 @@ void ac_init_opts( int ac, char* av[]){
             cerr << "  --load=<prog_path>      Load target application\n";
             cerr << "  -- <prog_path>          Load target application\n";
             cerr << "  --trace-cache=<cache>,<file> Trace cache access\n";
+            cerr << "  --dec-cache-dir=<dir>   Keep decoded instructions in <dir> between runs\n";
+            cerr << "  --plugin=<lib>[,<args>] Load instrumentation plugin <lib> (repeatable)\n";
+            cerr << "  --bin-trace=mem         Trace data accesses too (--bin-trace)\n";
+            cerr << "  --profile-period=<n>    Sample the pc every <n> instructions when profiling\n";
+            cerr << "  --host-cost-period=<n>  Time the behaviors every <n> instructions (--host-cost)\n";
+            cerr << "  --interval=<n>[ns]      Write statistics every <n> instructions or ns (--interval-stats)\n";
+            cerr << "  --interval-file=<file>  Write them to <file>, binary if it ends in .bin\n";
+            cerr << "  --detail-at=<n>         Run in detail from instruction <n> on (--fast-forward)\n";
+            cerr << "  --detail-pc=<addr>      Run in detail whenever the pc reaches <addr>\n";
+            cerr << "  --detail-instr=<name>   Run in detail whenever instruction <name> runs\n";
+            cerr << "  --detail-length=<n>     End each detailed region after <n> instructions\n";
+            cerr << "  --bbv-interval=<n>      Write a basic block vector every <n> instructions (--bbv)\n";
+            cerr << "  --bbv-file=<file>       Write them to <file> instead of bb.out.<processor>\n";
+            cerr << "  --simpoints=<file>      Run in detail only the intervals listed by SimPoint\n";
+            cerr << "  --checkpoint-at=<n>     Save a checkpoint after <n> instructions (--checkpoint)\n";
+            cerr << "  --checkpoint-syscall=<name> Save one before the first call of syscall <name>\n";
+            cerr << "  --checkpoint-file=<file> Save them to <file> instead of <processor>.<n>.ckpt\n";
+            cerr << "  --restore=<file>        Start from checkpoint <file>\n";
+            cerr << "  --fork-server=<socket>  Fork a run per job received on <socket> (--fork-server)\n";
 #ifdef USE_GDB
             //      cerr << "  --gdb[=<port>]          Enable GDB support\n";
 #endif /* USE_GDB */
@@ -184,6 +258,265 @@ args_t ac_init_args( int ac, char* av[]){
             continue;
         }
 
+        else if ( (size>16) && (!strncmp(av[1], "--dec-cache-dir=", 16)) ) {
+            ac_dec_cache_dir = strdup(av[1]+16);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>9) && (!strncmp(av[1], "--plugin=", 9)) ) {
+            ac_plugins.push_back(av[1]+9);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>12) && (!strncmp(av[1], "--bin-trace=", 12)) ) {
+            if (strcmp(av[1]+12, "mem")) {
+                std::cerr << "Error: invalid binary trace mode: " << av[1]+12 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            ac_bin_trace_mem = true;
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>17) && (!strncmp(av[1], "--profile-period=", 17)) ) {
+            ac_profile_period = strtoul(av[1]+17, NULL, 0);
+            if (ac_profile_period == 0) {
+                std::cerr << "Error: invalid profile period: " << av[1]+17 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>11) && (!strncmp(av[1], "--interval=", 11)) ) {
+            char* unit;
+            ac_interval = strtoull(av[1]+11, &unit, 0);
+            ac_interval_ns = !strcmp(unit, "ns");
+            if (ac_interval == 0 || (*unit && !ac_interval_ns)) {
+                std::cerr << "Error: invalid interval: " << av[1]+11 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>16) && (!strncmp(av[1], "--interval-file=", 16)) ) {
+            ac_interval_file = strdup(av[1]+16);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>19) && (!strncmp(av[1], "--host-cost-period=", 19)) ) {
+            ac_host_cost_period = strtoul(av[1]+19, NULL, 0);
+            if (ac_host_cost_period == 0) {
+                std::cerr << "Error: invalid host cost period: " << av[1]+19 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>12) && (!strncmp(av[1], "--detail-at=", 12)) ) {
+            ac_detail_at = strtoull(av[1]+12, NULL, 0);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>12) && (!strncmp(av[1], "--detail-pc=", 12)) ) {
+            char* end;
+            ac_detail_pc = strtoull(av[1]+12, &end, 0);
+            if (*end || end == av[1]+12 || ac_detail_pc > 0xffffffffULL) {
+                std::cerr << "Error: invalid pc: " << av[1]+12 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>15) && (!strncmp(av[1], "--detail-instr=", 15)) ) {
+            ac_detail_instr = strdup(av[1]+15);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>16) && (!strncmp(av[1], "--detail-length=", 16)) ) {
+            ac_detail_length = strtoull(av[1]+16, NULL, 0);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>15) && (!strncmp(av[1], "--bbv-interval=", 15)) ) {
+            ac_bbv_interval = strtoull(av[1]+15, NULL, 0);
+            if (ac_bbv_interval == 0) {
+                std::cerr << "Error: invalid basic block vector interval: " << av[1]+15 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>11) && (!strncmp(av[1], "--bbv-file=", 11)) ) {
+            ac_bbv_file = strdup(av[1]+11);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>12) && (!strncmp(av[1], "--simpoints=", 12)) ) {
+            ac_simpoints = strdup(av[1]+12);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>16) && (!strncmp(av[1], "--checkpoint-at=", 16)) ) {
+            ac_checkpoint_at = strtoull(av[1]+16, NULL, 0);
+            if (ac_checkpoint_at == 0) {
+                std::cerr << "Error: invalid checkpoint instruction count: " << av[1]+16 << "\n";
+                exit(EXIT_FAILURE);
+            }
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>21) && (!strncmp(av[1], "--checkpoint-syscall=", 21)) ) {
+            ac_checkpoint_syscall = strdup(av[1]+21);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>18) && (!strncmp(av[1], "--checkpoint-file=", 18)) ) {
+            ac_checkpoint_file = strdup(av[1]+18);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>10) && (!strncmp(av[1], "--restore=", 10)) ) {
+            ac_restore_file = strdup(av[1]+10);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
+        else if ( (size>14) && (!strncmp(av[1], "--fork-server=", 14)) ) {
+            ac_fork_server_socket = strdup(av[1]+14);
+            // Remove this parameter from the list and reset the loop
+            for (int i = 1; i <= ac; i++) {
+                av[i] = av[i+1];
+            }
+
+            ac_argc--;
+            ac--;
+            continue;
+        }
+
         ac --;
         av ++;
     }
@@ -203,6 +536,24 @@ args_t ac_init_args( int ac, char* av[]){
     return args;
 }
 
+//Output file name for this process: in a fork server job, name with
+//.job<n> before its extension, so that jobs do not write the same file
+std::string ac_output_name(const std::string& name)
+{
+  if (!ac_fork_job)
+    return name;
+
+  std::ostringstream job;
+  size_t base = name.find_last_of('/');
+  size_t ext = name.find_last_of('.');
+
+  job << ".job" << ac_fork_job;
+  base = base == std::string::npos ? 0 : base + 1;
+  if (ext == std::string::npos || ext <= base)
+    return name + job.str();
+  return name.substr(0, ext) + job.str() + name.substr(ext);
+}
+
 unsigned int convert_endian(unsigned int size, unsigned int num, bool match_endian)
 {
   unsigned char *in = (unsigned char*) &num;
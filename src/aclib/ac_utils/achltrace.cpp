@@ -0,0 +1,119 @@
+// Expands a binary .hltrace stream written by ArchC simulators (-hlt) to
+// the text format: a source path line whenever the trace changes file and
+// a line number line whenever it changes line.
+//
+// Usage: achltrace <trace.hltrace> [<output>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ac_hltrace.H"
+
+static const char *trace_name;
+
+static void corrupt()
+{
+  fprintf(stderr, "achltrace: %s: corrupt or truncated trace\n", trace_name);
+  exit(EXIT_FAILURE);
+}
+
+// Reads an unsigned LEB128 value. Returns false at the end of the file.
+static bool get_leb128(FILE *in, unsigned long long *value)
+{
+  unsigned shift = 0;
+  int c;
+
+  *value = 0;
+  while ((c = getc_unlocked(in)) != EOF)
+  {
+    if (shift > 63)
+      corrupt();
+    *value |= (unsigned long long) (c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+    shift += 7;
+  }
+  if (shift)
+    corrupt();
+  return false;
+}
+
+int main(int argc, char *argv[])
+{
+  char magic[AC_HLTRACE_MAGIC_SIZE];
+  std::vector<std::string> paths;
+  unsigned long long tag;
+  long long line = 0;
+  FILE *in, *out = stdout;
+
+  if (argc != 2 && argc != 3)
+  {
+    fprintf(stderr, "Usage: %s <trace.hltrace> [<output>]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  trace_name = argv[1];
+  if ((in = fopen(trace_name, "rb")) == NULL)
+  {
+    perror(trace_name);
+    return EXIT_FAILURE;
+  }
+  if (argc == 3 && (out = fopen(argv[2], "w")) == NULL)
+  {
+    perror(argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+      memcmp(magic, AC_HLTRACE_MAGIC, sizeof(magic)))
+  {
+    fprintf(stderr, "achltrace: %s: not a binary high-level trace\n", trace_name);
+    return EXIT_FAILURE;
+  }
+
+  while (get_leb128(in, &tag))
+  {
+    unsigned long long arg = tag >> 2;
+
+    switch (tag & 3)
+    {
+      case AC_HLTRACE_LINE:
+        line += (arg & 1) ? -(long long) (arg >> 1) - 1 : (long long) (arg >> 1);
+        fprintf(out, "%lld\n", line);
+        break;
+
+      case AC_HLTRACE_FILE:
+        if (arg >= paths.size())
+          corrupt();
+        fprintf(out, "%s\n", paths[arg].c_str());
+        break;
+
+      case AC_HLTRACE_PATH:
+      {
+        unsigned long long size;
+        if (arg > (1 << 24) || !get_leb128(in, &size) || size > (1 << 20))
+          corrupt();
+        std::string path(size, '\0');
+        if (size && fread(&path[0], 1, size, in) != size)
+          corrupt();
+        if (arg >= paths.size())
+          paths.resize(arg + 1);
+        paths[arg] = path;
+        break;
+      }
+
+      default:
+        corrupt();
+    }
+  }
+
+  fclose(in);
+  if (fclose(out) != 0)
+  {
+    perror(argc == 3 ? argv[2] : "stdout");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
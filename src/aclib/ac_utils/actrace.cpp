@@ -0,0 +1,132 @@
+// Expands a binary instruction trace written by ArchC simulators
+// (--bin-trace) to text. By default it prints one hexadecimal pc per
+// instruction, as the --debug trace does; -i adds the instruction id and
+// -m prints the data accesses as "R|W <address> <size>" lines.
+//
+// Usage: actrace [-i] [-m] <trace.btrace> [<output>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "ac_bin_trace.H"
+
+static const char *trace_name;
+
+static void corrupt()
+{
+  fprintf(stderr, "actrace: %s: corrupt or truncated trace\n", trace_name);
+  exit(EXIT_FAILURE);
+}
+
+// Reads an unsigned LEB128 value. Returns false at the end of the file.
+static bool get_leb128(FILE *in, uint64_t *value)
+{
+  unsigned shift = 0;
+  int c;
+
+  *value = 0;
+  while ((c = getc_unlocked(in)) != EOF)
+  {
+    if (shift > 63)
+      corrupt();
+    *value |= (uint64_t) (c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+    shift += 7;
+  }
+  if (shift)
+    corrupt();
+  return false;
+}
+
+static inline uint32_t unzigzag(uint32_t from, uint64_t z)
+{
+  return (uint32_t) (from + ((z & 1) ? -(int64_t) (z >> 1) - 1 : (int64_t) (z >> 1)));
+}
+
+int main(int argc, char *argv[])
+{
+  char magic[AC_BIN_TRACE_MAGIC_SIZE];
+  bool ids = false, mem = false;
+  uint32_t pc = 0, addr = 0;
+  uint64_t tag, arg;
+  FILE *in, *out = stdout;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "im")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i':
+        ids = true;
+        break;
+      case 'm':
+        mem = true;
+        break;
+      default:
+        optind = argc + 1;
+    }
+  }
+  if (argc - optind != 1 && argc - optind != 2)
+  {
+    fprintf(stderr, "Usage: %s [-i] [-m] <trace.btrace> [<output>]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  trace_name = argv[optind];
+  if ((in = fopen(trace_name, "rb")) == NULL)
+  {
+    perror(trace_name);
+    return EXIT_FAILURE;
+  }
+  if (argc - optind == 2 && (out = fopen(argv[optind + 1], "w")) == NULL)
+  {
+    perror(argv[optind + 1]);
+    return EXIT_FAILURE;
+  }
+
+  if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+      memcmp(magic, AC_BIN_TRACE_MAGIC, sizeof(magic)))
+  {
+    fprintf(stderr, "actrace: %s: not a binary instruction trace\n", trace_name);
+    return EXIT_FAILURE;
+  }
+
+  while (get_leb128(in, &tag))
+  {
+    if (!get_leb128(in, &arg))
+      corrupt();
+
+    switch (tag & 3)
+    {
+      case AC_BIN_TRACE_INSTR:
+        pc = unzigzag(pc, tag >> 2);
+        if (ids)
+          fprintf(out, "%x %u\n", pc, (unsigned) arg);
+        else
+          fprintf(out, "%x\n", pc);
+        break;
+
+      case AC_BIN_TRACE_READ:
+      case AC_BIN_TRACE_WRITE:
+        addr = unzigzag(addr, tag >> 2);
+        if (mem)
+          fprintf(out, "%c %x %u\n", (tag & 3) == AC_BIN_TRACE_READ ? 'R' : 'W',
+                  addr, (unsigned) arg);
+        break;
+
+      default:
+        corrupt();
+    }
+  }
+
+  fclose(in);
+  if (fclose(out) != 0)
+  {
+    perror(argc - optind == 2 ? argv[optind + 1] : "stdout");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -41,6 +41,7 @@
 #include "acpp.h"
 #include "stdlib.h"
 #include "string.h"
+#include <ctype.h>
  #include <stdbool.h>
 
 
@@ -85,6 +86,24 @@ int  ACPCAddress=1;                             //!<Indicates if PC bounds is ve
 int  ACFullDecode=0;                            //!<Indicates if Full Decode Optimization is turned on or not
 int  ACCurInstrID=1;                            //!<Indicates if Current Instruction ID is save in dispatch
 int  ACPowerEnable=0;                           //!<Indicates if Power Estimation is enabled
+int  ACBlockCache=0;                            //!<Indicates if Basic Block Translation Cache is turned on or not
+int  ACSparseDecCache=0;                        //!<Indicates if the Decode Cache is paged and allocated on demand
+int  ACSelfModCode=0;                           //!<Indicates if stores to code invalidate the Decode Cache
+int  ACInlineDecoder=0;                         //!<Indicates if a model-specific decoder replaces the generic one
+int  ACPersistDecCache=0;                       //!<Indicates if decoded instructions are kept in a file between runs
+int  ACCallThread=0;                            //!<Indicates if hot blocks run as call-threaded host code
+int  ACIntCycles=0;                             //!<Indicates if cycles are counted as integers between quantum checks
+int  ACPlugins=0;                               //!<Indicates if instrumentation plugins can be loaded at run time
+int  ACBinTrace=0;                              //!<Indicates if instructions are traced to a binary file instead of text
+int  ACProfile=0;                               //!<Indicates if the guest pc is sampled for a flat profile
+int  ACCallGraph=0;                             //!<Indicates if guest calls and returns are tracked for a call graph
+int  ACHostCost=0;                              //!<Indicates if host cycles spent in behaviors and dispatch are sampled
+int  ACIntervalStats=0;                         //!<Indicates if counters are written as a time series of intervals
+int  ACFastForward=0;                           //!<Indicates if a functional dispatch runs outside the detailed regions
+int  ACBBV=0;                                   //!<Indicates if basic block vectors are written per interval
+int  ACCheckpoint=0;                            //!<Indicates if architectural checkpoints are saved and restored
+int  ACForkServer=0;                            //!<Indicates if runs are forked from a loaded simulator per job
+int  ACGDBPatch=0;                              //!<Indicates if GDB breakpoints redirect Decode Cache entries (set from other options)
 
 char ACOptions[500];                            //!<Stores ArchC recognized command line options
 char *ACOptions_p = ACOptions;                  //!<Pointer used to append options in ACOptions
@@ -140,6 +159,23 @@ struct option_map option_map[] = {
   {"--full-decode"     , "-fdc","Enable Full Decode Optimization.", 0},
   {"--no-curr-instr-id", "-nci","Disable Current Instruction ID save in dispatch.", 0},
   {"--power"           , "-pw" ,"Enable Power Estimation.", 0},
+  {"--block-cache"     , "-bbc","Enable Basic Block Translation Cache.", 0},
+  {"--sparse-dec-cache", "-sdc","Enable Sparse (paged) Decode Cache.", 0},
+  {"--self-mod-code"   , "-smc","Invalidate decoded instructions overwritten by stores.", 0},
+  {"--inline-decoder"  , "-idec","Generate a model-specific decoder function.", 0},
+  {"--persistent-dec-cache", "-pdc","Keep decoded instructions in a file between runs (--dec-cache-dir).", 0},
+  {"--call-threading"  , "-cth","Run hot blocks as call-threaded x86-64 host code.", 0},
+  {"--int-cycles"      , "-ic" ,"Count cycles as integers, checking the quantum at control flow instructions.", 0},
+  {"--plugins"         , "-plg","Enable instrumentation plugins loaded at run time (--plugin=<lib>).", 0},
+  {"--bin-trace"       , "-btr","Trace instructions to a binary file (see actrace) instead of text.", 0},
+  {"--profile"         , "-prof","Sample the guest pc for a flat profile of the program (--profile-period=<n>).", 0},
+  {"--call-graph"      , "-cg" ,"Track guest calls and returns for a callgrind call graph (needs -abi).", 0},
+  {"--host-cost"       , "-hc" ,"Sample the host cycles spent in each behavior and in dispatch (--host-cost-period=<n>).", 0},
+  {"--interval-stats"  , "-is" ,"Write statistics per interval of instructions or time (--interval=<n>[ns]); implies -s.", 0},
+  {"--fast-forward"    , "-ff" ,"Run functionally outside the detailed regions (--detail-at/pc/instr=, --simpoints=).", 0},
+  {"--bbv"             , "-bbv","Write basic block vectors per interval for SimPoint (--bbv-interval=<n>).", 0},
+  {"--checkpoint"      , "-ckp","Save and restore architectural checkpoints (--checkpoint-at=<n>, --restore=<file>).", 0},
+  {"--fork-server"     , "-fks","Fork a run per job received on a Unix socket after loading once (--fork-server=<socket>).", 0},
   { }
 };
 
@@ -234,6 +270,7 @@ int main(int argc, char** argv) {
   extern ac_stg_list *stage_list;
   extern ac_pipe_list *pipe_list;
   extern int HaveFormattedRegs;
+  extern int HaveMemHier;
   extern int HaveTLMIntrPorts;
 /***/
   extern int HaveTLM2IntrPorts;
@@ -373,6 +410,75 @@ int main(int argc, char** argv) {
             case OPPower:
               ACPowerEnable = 1;
               ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPBlockCache:
+              ACBlockCache = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPSparseDecCache:
+              ACSparseDecCache = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPSelfModCode:
+              ACSelfModCode = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPInlineDecoder:
+              ACInlineDecoder = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPPersistDecCache:
+              ACPersistDecCache = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPCallThread:
+              ACCallThread = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPIntCycles:
+              ACIntCycles = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPPlugins:
+              ACPlugins = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPBinTrace:
+              ACBinTrace = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPProfile:
+              ACProfile = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPCallGraph:
+              ACCallGraph = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPHostCost:
+              ACHostCost = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPIntervalStats:
+              ACIntervalStats = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPFastForward:
+              ACFastForward = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPBBV:
+              ACBBV = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPCheckpoint:
+              ACCheckpoint = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
+            case OPForkServer:
+              ACForkServer = 1;
+              ACOptions_p += sprintf( ACOptions_p, "%s ", argv[0]);
+              break;
             default:
               break;
           }
@@ -389,6 +495,50 @@ int main(int argc, char** argv) {
   }
   
   if ( !ACDecCacheFlag ) ACFullDecode = 0;
+  /* call-threaded blocks call the threaded interpreter routines and keep
+     pointers to decode cache entries, which must not change under them */
+  if ( !ACDecCacheFlag || !ACThreading || ACDelayFlag || ACSelfModCode ) ACCallThread = 0;
+  /* call-threaded blocks would run over breakpoints */
+  if ( ACGDBIntegrationFlag ) ACCallThread = 0;
+  if ( ACCallThread ) ACBlockCache = 0;
+  /* blocks do not commit delayed assignments between their instructions */
+  if ( !ACDecCacheFlag || !ACThreading || ACDelayFlag ) ACBlockCache = 0;
+  if ( !ACDecCacheFlag ) ACSparseDecCache = 0;
+  if ( !ACDecCacheFlag ) ACSelfModCode = 0;
+  if ( ACSelfModCode ) ACFullDecode = 0;
+  if ( !ACDecCacheFlag ) ACInlineDecoder = 0;
+  /* code rewritten at run time must not be saved for the next runs */
+  if ( !ACDecCacheFlag || ACSelfModCode ) ACPersistDecCache = 0;
+  if ( !ACWaitFlag ) ACIntCycles = 0;
+  /* instrumented instructions are redirected through their decode cache
+     entry before the generic behavior runs, which only an ABI defers;
+     GDB breakpoints redirect the same entries */
+  if ( !ACThreading || !ACDecCacheFlag || !ACABIFlag || ACGDBIntegrationFlag ) ACPlugins = 0;
+  /* plugins see instructions as they are decoded, on the simulator thread */
+  if ( ACPlugins ) ACFullDecode = 0;
+  /* control flow is reported before the generic behavior moves ac_pc,
+     which only an ABI defers into the instruction routines */
+  if ( !ACThreading || !ACABIFlag ) ACCallGraph = 0;
+  /* sampled instructions run in a routine of their own, chosen by
+     dispatch(); GDB and plugins redirect decode cache entries the same
+     way, and call-threaded blocks do not go through dispatch() */
+  if ( !ACThreading || !ACDecCacheFlag || ACGDBIntegrationFlag || ACPlugins ) ACHostCost = 0;
+  if ( ACHostCost ) ACCallThread = ACBlockCache = 0;
+  /* the instruction mix and syscalls come from the --stats counters */
+  if ( ACIntervalStats ) ACStatsFlag = 1;
+  /* the functional dispatch hands decoded instructions to their routine;
+     it has no breakpoint checks and does not commit delayed assignments,
+     and call-threaded blocks would not go back to it */
+  if ( !ACThreading || !ACDecCacheFlag || ACGDBIntegrationFlag || ACDelayFlag ) ACFastForward = 0;
+  if ( ACFastForward ) ACCallThread = ACBlockCache = 0;
+  /* blocks are numbered in the decode cache entry of their first instruction */
+  if ( !ACDecCacheFlag ) ACBBV = 0;
+  /* assignments still waiting on the delay queues are not saved */
+  if ( ACDelayFlag ) ACCheckpoint = 0;
+  /* every run would share the connection to the debugger */
+  if ( ACGDBIntegrationFlag ) ACForkServer = 0;
+  /* breakpoints redirect the interpretation routine of decoded instructions */
+  ACGDBPatch = ACGDBIntegrationFlag && ACThreading && ACDecCacheFlag;
 
   //Loading Configuration Variables
   ReadConfFile();
@@ -423,6 +573,43 @@ int main(int argc, char** argv) {
   if (error_flag)
     return EXIT_FAILURE;
 
+  //Blocks are terminated by instructions declared with is_jump/is_branch.
+  //Without them no block would ever end, so the block cache is not used.
+  if( ACBlockCache && !HaveCflow() ){
+    AC_MSG("Warning: No control flow instruction declared (is_jump/is_branch). Basic Block Cache disabled.\n");
+    ACBlockCache = 0;
+  }
+
+  //Blocks do not sleep on the interrupt ports between instructions.
+  if( ACBlockCache && (HaveTLMIntrPorts || HaveTLM2IntrPorts) ){
+    AC_MSG("Warning: Interrupt ports declared. Basic Block Cache disabled.\n");
+    ACBlockCache = 0;
+  }
+
+  //Calls and returns are only seen through instructions declared with is_jump/is_branch.
+  if( ACCallGraph && !HaveCflow() ){
+    AC_MSG("Warning: No control flow instruction declared (is_jump/is_branch). Call graph disabled.\n");
+    ACCallGraph = 0;
+  }
+
+  //Call-threaded blocks do not sleep on the interrupt ports between instructions.
+  if( ACCallThread && (HaveTLMIntrPorts || HaveTLM2IntrPorts) ){
+    AC_MSG("Warning: Interrupt ports declared. Call threading disabled.\n");
+    ACCallThread = 0;
+  }
+
+  //Write-back caches may hold the only copy of data, which checkpoints would miss.
+  if( ACCheckpoint && HaveMemHier ){
+    AC_MSG("Warning: Memory hierarchy declared. Checkpoints disabled.\n");
+    ACCheckpoint = 0;
+  }
+
+  //GDB support starts on SIGUSR2, which also requests checkpoints.
+  if( ACCheckpoint && ACGDBIntegrationFlag ){
+    AC_MSG("Warning: GDB support requested. Checkpoints disabled.\n");
+    ACCheckpoint = 0;
+  }
+
   if( wordsize == 0){
     AC_MSG("Warning: No wordsize defined. Default value is 32 bits.\n");
     wordsize = 32;
@@ -1070,6 +1257,39 @@ void CreateParmHeader() {
   
   if( ACLongJmpStop || ACThreading )
     fprintf( output, "#define  AC_ACTION_STOP 2\t //!< Indicates action value to stop used by longjmp.\n\n");
+
+  if( ACSelfModCode )
+    fprintf( output, "#define  AC_TRACK_CODE_WRITES \t //!< Indicates that stores to decoded instructions invalidate the decode cache.\n\n");
+
+  if( ACPlugins )
+    fprintf( output, "#define  AC_PLUGINS \t //!< Indicates that memory ports report data accesses to plugins.\n\n");
+
+  if( ACBinTrace )
+    fprintf( output, "#define  AC_BIN_TRACE \t //!< Indicates that instructions are traced to a binary file.\n\n");
+
+  if( ACProfile )
+    fprintf( output, "#define  AC_PROFILE \t //!< Indicates that the guest pc is sampled for a flat profile.\n\n");
+
+  if( ACCallGraph )
+    fprintf( output, "#define  AC_CALL_GRAPH \t //!< Indicates that guest calls and returns are tracked for a call graph.\n\n");
+
+  if( ACHostCost )
+    fprintf( output, "#define  AC_HOST_COST \t //!< Indicates that host cycles spent in behaviors are sampled.\n\n");
+
+  if( ACIntervalStats )
+    fprintf( output, "#define  AC_INTERVAL_STATS \t //!< Indicates that counters are written per interval.\n\n");
+
+  if( ACFastForward )
+    fprintf( output, "#define  AC_FAST_FORWARD \t //!< Indicates that a functional dispatch runs outside the detailed regions.\n\n");
+
+  if( ACBBV )
+    fprintf( output, "#define  AC_BBV \t //!< Indicates that basic block vectors are written per interval.\n\n");
+
+  if( ACCheckpoint )
+    fprintf( output, "#define  AC_CHECKPOINT \t //!< Indicates that architectural checkpoints are saved and restored.\n\n");
+
+  if( ACForkServer )
+    fprintf( output, "#define  AC_FORK_SERVER \t //!< Indicates that runs are forked from the loaded simulator per job.\n\n");
   
   /* parms namespace definition */
   fprintf(output, "namespace %s_parms {\n\n", project_name);
@@ -1538,6 +1758,32 @@ void CreateProcessorHeader() {
   fprintf( output, "#include \"systemc.h\"\n");
   fprintf( output, "#include \"ac_module.H\"\n");
   fprintf( output, "#include \"ac_utils.H\"\n");
+  if (ACSparseDecCache)
+    fprintf( output, "#include \"ac_dec_cache.H\"\n");
+  if (ACBlockCache)
+    fprintf( output, "#include \"ac_block_cache.H\"\n");
+  if (ACCallThread)
+    fprintf( output, "#include \"ac_call_thread.H\"\n");
+  if (ACPlugins)
+    fprintf( output, "#include \"ac_plugin.H\"\n");
+  if (ACBinTrace)
+    fprintf( output, "#include \"ac_bin_trace.H\"\n");
+  if (ACProfile)
+    fprintf( output, "#include \"ac_profile.H\"\n");
+  if (ACCallGraph)
+    fprintf( output, "#include \"ac_callgraph.H\"\n");
+  if (ACHostCost)
+    fprintf( output, "#include \"ac_host_cost.H\"\n");
+  if (ACIntervalStats)
+    fprintf( output, "#include \"ac_interval_stats.H\"\n");
+  if (ACFastForward)
+    fprintf( output, "#include \"ac_fast_forward.H\"\n");
+  if (ACBBV)
+    fprintf( output, "#include \"ac_bbv.H\"\n");
+  if (ACCheckpoint)
+    fprintf( output, "#include \"ac_checkpoint.H\"\n");
+  if (ACForkServer)
+    fprintf( output, "#include \"ac_fork_server.H\"\n");
 #ifdef HLT_SUPPORT
   fprintf( output, "#include \"ac_hltrace.H\"\n");
 #endif
@@ -1583,7 +1829,7 @@ if (HaveTLM2IntrPorts) {
   if( ACDecCacheFlag ) {
     EmitDecCache(output, 1);
   }
-  if( ACWaitFlag ) {
+  if( ACWaitFlag && !ACIntCycles ) {
     for(int temp=1; temp<=5; temp++) {
       for (ac_dec_instr *pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
         if (pinstr->cycles == temp) {
@@ -1637,10 +1883,97 @@ if (HaveTLM2IntrPorts) {
     COMMENT(INDENT[1], "Address of Interpretation Routines.");
     fprintf( output, "%svoid** IntRoutine;\n\n", INDENT[1]);
   }
+
+  if (ACBlockCache) {
+    COMMENT(INDENT[1], "Address of the Routine leaving a Basic Block.");
+    fprintf( output, "%svoid* BlockExit;\n", INDENT[1]);
+    fprintf( output, "%sac_block_cache<DecCacheItem> BB;\n\n", INDENT[1]);
+  }
+
+  if (ACCallThread) {
+    COMMENT(INDENT[1], "Address of the Routine running a call-threaded block.");
+    fprintf( output, "%svoid* CallThreadEntry;\n", INDENT[1]);
+    fprintf( output, "%sac_call_thread CT;\n\n", INDENT[1]);
+  }
+
+  if (ACPlugins) {
+    COMMENT(INDENT[1], "Address of the Routine calling the plugins before an instrumented instruction.");
+    fprintf( output, "%svoid* PluginEntry;\n", INDENT[1]);
+    fprintf( output, "%sac_plugin_host PLUGINS;\n\n", INDENT[1]);
+  }
+
+  if (ACSelfModCode) {
+    COMMENT(INDENT[1], "Membership of this processor in the shared code page map.");
+    fprintf( output, "%sac_code_pages CODE_PAGES;\n\n", INDENT[1]);
+  }
+
+  if (ACCallGraph) {
+    COMMENT(INDENT[1], "Shadow stack and call graph of this processor.");
+    fprintf( output, "%sac_callgraph CALLGRAPH;\n\n", INDENT[1]);
+  }
+
+  if (ACProfile) {
+    COMMENT(INDENT[1], "Sampling profile of this processor.");
+    fprintf( output, "%sac_profile PROFILE;\n\n", INDENT[1]);
+  }
+
+  if (ACHostCost) {
+    COMMENT(INDENT[1], "Address of the Routine timing the behaviors of a sampled instruction.");
+    fprintf( output, "%svoid* HostCostEntry;\n", INDENT[1]);
+    fprintf( output, "%sac_host_cost HOSTCOST;\n\n", INDENT[1]);
+  }
+
+  if (ACIntervalStats) {
+    COMMENT(INDENT[1], "Time series of the counters of this processor.");
+    fprintf( output, "%sac_interval_stats INTERVALS;\n\n", INDENT[1]);
+  }
+
+  if (ACFastForward) {
+    extern ac_sto_list *storage_list;
+    extern int HaveMemHier;
+    ac_sto_list *pstorage;
+
+    COMMENT(INDENT[1], "Triggers and state of the detailed regions.");
+    fprintf( output, "%sac_fast_forward FASTFWD;\n", INDENT[1]);
+    if (HaveMemHier) {
+      COMMENT(INDENT[1], "Cache statistics of the detailed regions.");
+      for (pstorage = storage_list; pstorage != NULL; pstorage = pstorage->next)
+        if (pstorage->type == CACHE || pstorage->type == ICACHE || pstorage->type == DCACHE)
+          fprintf( output, "%scache_statistics %s_detail;\n", INDENT[1], pstorage->name);
+    }
+    fprintf( output, "\n");
+  }
+
+  if (ACBBV) {
+    COMMENT(INDENT[1], "Basic block vectors of this processor.");
+    fprintf( output, "%sac_bbv BBV;\n\n", INDENT[1]);
+  }
+
+  if (ACCheckpoint) {
+    COMMENT(INDENT[1], "Checkpoint triggers and files of this processor.");
+    fprintf( output, "%sac_checkpoint CKP;\n\n", INDENT[1]);
+  }
+
+  if (ACForkServer) {
+    COMMENT(INDENT[1], "Jobs forked from this processor once loaded.");
+    fprintf( output, "%sac_fork_server FORKSRV;\n\n", INDENT[1]);
+  }
+
+  if (ACGDBPatch) {
+    COMMENT(INDENT[1], "Address of the Routine handing control to GDB.");
+    fprintf( output, "%svoid* BreakEntry;\n", INDENT[1]);
+    COMMENT(INDENT[1], "GDB stops before every instruction (first stop or step mode).");
+    fprintf( output, "%sbool gdb_step;\n\n", INDENT[1]);
+  }
   
   if(ACDecCacheFlag){
-    fprintf( output, "%sDecCacheItem* DEC_CACHE;\n", INDENT[1]);
+    if(ACSparseDecCache)
+      fprintf( output, "%sac_dec_cache<DecCacheItem> DEC_CACHE;\n", INDENT[1]);
+    else
+      fprintf( output, "%sDecCacheItem* DEC_CACHE;\n", INDENT[1]);
     fprintf( output, "%sDecCacheItem* instr_dec;\n", INDENT[1]);
+    if(ACPersistDecCache)
+      fprintf( output, "%sac_dec_cache_file DEC_FILE;\n", INDENT[1]);
   }
   else
     fprintf( output, "%sunsigned* ins_cache;\n", INDENT[1]);
@@ -1660,6 +1993,56 @@ if (HaveTLM2IntrPorts) {
              "%sinline __attribute__((always_inline)) void* dispatch();\n\n", 
              INDENT[1]);
   }
+
+  if (ACFastForward) {
+    COMMENT(INDENT[1], "Functional Dispatch Method, NULL when a detailed region starts.");
+    fprintf( output, 
+             "%sinline __attribute__((always_inline)) void* dispatch_fast();\n\n", 
+             INDENT[1]);
+  }
+
+  if (ACBlockCache) {
+    COMMENT(INDENT[1], "In-block Dispatch Method.");
+    fprintf( output, 
+             "%sinline __attribute__((always_inline)) void* dispatch_block();\n\n", 
+             INDENT[1]);
+  }
+
+  if (ACInlineDecoder) {
+    COMMENT(INDENT[1], "Decodes the instruction at decode_pc into instr_dec.");
+    fprintf( output, 
+             "%sinline __attribute__((always_inline)) unsigned decode_instr(DecCacheItem* instr_dec, %s_parms::ac_word* buffer, unsigned decode_pc);\n\n", 
+             INDENT[1], project_name);
+  }
+
+  if (ACFullDecode) {
+    COMMENT(INDENT[1], "Decodes [first, last) into the Decode Cache. Thread safe.");
+    fprintf( output, "%svoid predecode(unsigned first, unsigned last);\n\n", INDENT[1]);
+  }
+
+  if (ACCallThread) {
+    extern ac_dec_instr *instr_list;
+    ac_dec_instr *pinstr;
+
+    COMMENT(INDENT[1], "Builds the call-threaded block starting at ac_pc. Returns false if it is left to the interpreter.");
+    fprintf( output, "%sbool ct_build(DecCacheItem* head);\n\n", INDENT[1]);
+    COMMENT(INDENT[1], "Functions called by call-threaded blocks, one per instruction.");
+    for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next)
+      fprintf( output, "%sint ct_%s(DecCacheItem* dec, unsigned next_pc);\n", 
+               INDENT[1], pinstr->name);
+    fprintf( output, "\n");
+  }
+
+  if (ACGDBPatch) {
+    COMMENT(INDENT[1], "Hands control to GDB before instr_dec runs. Returns the routine to go on with.");
+    fprintf( output, "%svoid* gdb_break();\n\n", INDENT[1]);
+  }
+
+  if (ACPersistDecCache) {
+    COMMENT(INDENT[1], "Reads and writes the Decode Cache file (--dec-cache-dir).");
+    fprintf( output, "%svoid load_dec_cache();\n", INDENT[1]);
+    fprintf( output, "%svoid save_dec_cache();\n\n", INDENT[1]);
+  }
   
   COMMENT(INDENT[1], "Behavior execution method.");
   fprintf( output, "%svoid behavior();\n\n", INDENT[1]);
@@ -1736,20 +2119,53 @@ if (HaveTLM2IntrPorts) {
     fprintf(output, "%sgdbstub = new AC_GDB<%s_parms::ac_word>(this, %s_parms::GDB_PORT_NUM);\n\n", 
             INDENT[2], project_name, project_name);
 
+  if (ACGDBPatch)
+    fprintf(output, "%sgdb_step = false;\n\n", INDENT[2]);
+
   if (ACWaitFlag)
     fprintf(output, "%sset_proc_freq(1000/module_period_ns);\n", INDENT[2]);
 
+  if (ACSelfModCode)
+    fprintf(output, "%scode_pages = CODE_PAGES.track(this, &invalidate_code);\n", INDENT[2]);
+
   fprintf( output, "%s}\n\n", INDENT[1]);  //end constructor
 
   if(ACDecCacheFlag) {
     fprintf( output, "%svoid init_dec_cache() {\n", INDENT[1]);
-    fprintf( output, "%sDEC_CACHE = (DecCacheItem*) calloc(sizeof(DecCacheItem), (dec_cache_size", 
-             INDENT[2]);
+    if( ACSparseDecCache )
+      fprintf( output, "%sDEC_CACHE.init(dec_cache_size", INDENT[2]);
+    else
+      fprintf( output, "%sDEC_CACHE = (DecCacheItem*) calloc(sizeof(DecCacheItem), (dec_cache_size", 
+               INDENT[2]);
     if( ACIndexFix ) fprintf( output, " / %d", largest_format_size / 8);
-    fprintf( output, "));\n");
+    if( ACSparseDecCache )
+      fprintf( output, ");\n");
+    else
+      fprintf( output, "));\n");
+    if( ACCallThread )
+      fprintf( output, "%sCT.reset();\n", INDENT[2]);
     fprintf( output, "%s}\n\n", INDENT[1]);  //end init_dec_cache
   }
 
+  if(ACSelfModCode) {
+    fprintf( output, "%svoid invalidate_dec_cache(unsigned address, unsigned size);\n\n", INDENT[1]);
+    fprintf( output, "%sstatic void invalidate_code(void* proc, unsigned address, unsigned size) {\n", 
+             INDENT[1]);
+    fprintf( output, "%s((%s*) proc)->invalidate_dec_cache(address, size);\n", INDENT[2], project_name);
+    fprintf( output, "%s}\n\n", INDENT[1]);
+  }
+
+  if(ACIntervalStats)
+    fprintf( output, "%svoid interval_sample();\n\n", INDENT[1]);
+
+  if(ACFastForward)
+    fprintf( output, "%svoid fast_forward_switch();\n\n", INDENT[1]);
+
+  if(ACCheckpoint) {
+    fprintf( output, "%svoid checkpoint_save(unsigned long long count);\n", INDENT[1]);
+    fprintf( output, "%svoid checkpoint_restore();\n\n", INDENT[1]);
+  }
+
   if(ACGDBIntegrationFlag) {
     fprintf( output, "%s/***********\n", INDENT[1]);
     fprintf( output, "%s * GDB Support - user supplied methods\n", INDENT[1]);
@@ -1777,6 +2193,12 @@ if (HaveTLM2IntrPorts) {
     fprintf( output, "%s/* GDB stub access */\n", INDENT[1]);
     fprintf( output, "%sAC_GDB<%s_parms::ac_word>* get_gdbstub();\n", 
              INDENT[1], project_name);
+
+    if (ACGDBPatch) {
+      fprintf( output, "\n%s/* Breakpoints */\n", INDENT[1]);
+      fprintf( output, "%svoid break_inserted( unsigned int address );\n", INDENT[1]);
+      fprintf( output, "%svoid break_removed( unsigned int address );\n", INDENT[1]);
+    }
   }
 
   if (ACWaitFlag) {
@@ -2060,9 +2482,27 @@ void CreateProcessorImpl() {
     if( ACABIFlag )
         fprintf( output, "#include  \"%s_syscall.H\"\n\n", project_name);
 
+    if( ACInlineDecoder )
+        EmitInlineDecoder(output, 0);
+
+    if( ACFullDecode )
+        EmitPredecode(output, 0);
+
+    if( ACPersistDecCache )
+        EmitDecCacheFile(output, 0);
+
+    if( ACFastForward )
+        EmitFastDispatch(output, 0);
+
     if( ACThreading )
         EmitDispatch(output, 0);
 
+    if( ACBlockCache )
+        EmitBlockDispatch(output, 0);
+
+    if( ACCallThread )
+        EmitCallThread(output, 0);
+
     fprintf( output, "void %s::behavior() {\n\n", project_name);
     if( ACDebugFlag ){
         fprintf( output, "%sextern bool ac_do_trace;\n", INDENT[1]);
@@ -2081,25 +2521,98 @@ void CreateProcessorImpl() {
     fprintf(output, "%shas_delayed_load = false;\n", INDENT[2]);
     fprintf(output, "%s}\n\n", INDENT[1]);
 
+    /* before the decode cache is filled from the restored memory */
+    if( ACCheckpoint ) {
+        fprintf(output, "%sCKP.open(name());\n", INDENT[1]);
+        fprintf(output, "%sif (ac_restore_file)\n", INDENT[1]);
+        fprintf(output, "%scheckpoint_restore();\n\n", INDENT[2]);
+    }
+
+    /* each job starts from the loaded and decoded program, before the
+       files of the profiling options are opened for it */
+    if( ACForkServer ) {
+        EmitDecodeWarmup(output, 1);
+        fprintf(output, "%sif (FORKSRV.serve()) {\n", INDENT[1]);
+        /* the restored guest has already read its arguments */
+        if( ACCheckpoint ) {
+            fprintf(output, "%sif (ac_restore_file)\n", INDENT[2]);
+            fprintf(output, "%sAC_WARN(\"Job arguments ignored, the program was restored from \" << ac_restore_file);\n", 
+                    INDENT[3]);
+            fprintf(output, "%selse {\n", INDENT[2]);
+            fprintf(output, "%sset_args(FORKSRV.argc, FORKSRV.argv);\n", INDENT[3]);
+            fprintf(output, "%sset_prog_args();\n", INDENT[3]);
+            fprintf(output, "%s}\n", INDENT[2]);
+        }
+        else {
+            fprintf(output, "%sset_args(FORKSRV.argc, FORKSRV.argv);\n", INDENT[2]);
+            fprintf(output, "%sset_prog_args();\n", INDENT[2]);
+        }
+        fprintf(output, "%s}\n\n", INDENT[1]);
+    }
+
     /*if( HaveMemHier ) {
       fprintf( output, "%sif( ac_wait_sig ) {\n", INDENT[1]);
       fprintf( output, "%sreturn;\n", INDENT[2]);
       fprintf( output, "%s}\n\n", INDENT[1]);
       }*/
 
-    if( ACFullDecode ) {
-        fprintf(output, "%sfor (decode_pc = ac_pc; decode_pc < dec_cache_size; decode_pc += %d) {\n", 
-                INDENT[1], largest_format_size / 8);
-        EmitDecodification(output, 2);
-        fprintf( output, "%s}\n\n", INDENT[1]);
+    if( ACPlugins ) {
+        fprintf(output, "%sPLUGINS.load(ac_plugins, \"%s\", ISA.instr_table, %s_parms::AC_DEC_INSTR_NUMBER);\n", 
+                INDENT[1], project_name, project_name);
+        fprintf(output, "%sif (PLUGINS.wants_mem())\n", INDENT[1]);
+        fprintf(output, "%smem_plugins = &PLUGINS;\n\n", INDENT[2]);
     }
 
+    if( ACCallGraph )
+        fprintf(output, "%sCALLGRAPH.open(name());\n\n", INDENT[1]);
+
+    if( ACProfile )
+        fprintf(output, "%sPROFILE.open(name(), code_segments, ac_profile_period%s);\n\n",
+                INDENT[1], ACCallGraph ? ", &CALLGRAPH" : "");
+
+    /* after the command line is read, which may ask for data accesses */
+    if( ACBinTrace )
+        fprintf(output, "%sac_bin_trace.open((std::string(name()) + \".btrace\").c_str(), ac_bin_trace_mem);\n\n", 
+                INDENT[1]);
+
+    if( ACHostCost ) {
+        ac_dec_format *pformat;
+        unsigned nformats = 0, f;
+
+        for (pformat = format_ins_list; pformat != NULL; pformat = pformat->next)
+            if (pformat->id > nformats)
+                nformats = pformat->id;
+        fprintf(output, "%sstatic const char* const host_cost_formats[] = {\"\"", INDENT[1]);
+        for (f = 1; f <= nformats; f++) {
+            for (pformat = format_ins_list; pformat != NULL && pformat->id != f; pformat = pformat->next);
+            fprintf(output, ", \"%s\"", pformat ? pformat->name : "");
+        }
+        fprintf(output, "};\n");
+        fprintf(output, "%sHOSTCOST.open(ac_host_cost_period, \"%s\", ISA.instr_table, %s_parms::AC_DEC_INSTR_NUMBER,\n", 
+                INDENT[1], project_name, project_name);
+        fprintf(output, "%shost_cost_formats, %u);\n\n", INDENT[3], nformats);
+    }
+
+    if( ACIntervalStats )
+        EmitIntervalOpen(output, 1);
+
+    if( ACBBV )
+        fprintf(output, "%sBBV.open(name(), ac_bbv_interval, ac_bbv_file);\n\n", INDENT[1]);
+
+    if( ACFastForward ) {
+        EmitFastForwardCaches(output, 1, "get_statistics");
+        fprintf(output, "%sFASTFWD.open(ISA.instr_table, %s_parms::AC_DEC_INSTR_NUMBER);\n\n", 
+                INDENT[1], project_name);
+    }
+
+    if( !ACForkServer )
+        EmitDecodeWarmup(output, 1);
+
     if ( ACThreading && ACABIFlag && ACDecCacheFlag) {
         fprintf( output, "%s#define AC_SYSC(NAME,LOCATION) \\\n", INDENT[1]);
-        fprintf( output, "%sinstr_dec = (DEC_CACHE + (LOCATION", INDENT[1]);
-        if( ACIndexFix ) 
-            fprintf( output, " / %d", largest_format_size / 8);
-        fprintf( output, ")); \\\n");
+        fprintf( output, "%sinstr_dec = ", INDENT[1]);
+        EmitDecCacheEntry( output, "LOCATION", 0);
+        fprintf( output, "; \\\n");
 
         if ( !ACFullDecode )
             fprintf( output, "%sinstr_dec->valid = true; \\\n", INDENT[1]);
@@ -2198,6 +2711,8 @@ void CreateProcessorImpl() {
     fprintf(output, "#ifdef USE_GDB\n");
     fprintf(output, "%ssignal(SIGUSR2, sigusr2_handler);\n", INDENT[1]);
     fprintf(output, "#endif\n");
+    if( ACCheckpoint )
+        fprintf(output, "%ssignal(SIGUSR2, ac_checkpoint::request);\n", INDENT[1]);
     fprintf(output, "%sset_running();\n", INDENT[1]);
     fprintf(output, "}\n\n");
 
@@ -2244,6 +2759,8 @@ void CreateProcessorImpl() {
     fprintf(output, "#ifdef USE_GDB\n");
     fprintf(output, "%ssignal(SIGUSR2, sigusr2_handler);\n", INDENT[1]);
     fprintf(output, "#endif\n");
+    if( ACCheckpoint )
+        fprintf(output, "%ssignal(SIGUSR2, ac_checkpoint::request);\n", INDENT[1]);
     fprintf(output, "%sset_running();\n", INDENT[1]);
     fprintf(output, "}\n\n");
 
@@ -2260,7 +2777,29 @@ void CreateProcessorImpl() {
     fprintf(output, "%sISA._behavior_end();\n", INDENT[1]);
     fprintf(output, "%sac_stop_flag = 1;\n", INDENT[1]);
     fprintf(output, "%sac_exit_status = status;\n", INDENT[1]);
+    if (ACIntCycles)
+        fprintf(output, "%sflush_cycles();\n", INDENT[1]);
     fprintf(output, "%sset_stopped();\n", INDENT[1]);
+    if (ACPersistDecCache)
+        fprintf(output, "%ssave_dec_cache();\n", INDENT[1]);
+    if (ACPlugins)
+        fprintf(output, "%sPLUGINS.finish();\n", INDENT[1]);
+    if (ACProfile)
+        fprintf(output, "%sPROFILE.close();\n", INDENT[1]);
+    if (ACCallGraph)
+        fprintf(output, "%sCALLGRAPH.close(ac_instr_counter);\n", INDENT[1]);
+    if (ACIntervalStats) {
+        fprintf(output, "%sinterval_sample();\n", INDENT[1]);
+        fprintf(output, "%sINTERVALS.close();\n", INDENT[1]);
+    }
+    if (ACBBV)
+        fprintf(output, "%sBBV.close(ac_instr_counter);\n", INDENT[1]);
+    if (ACFastForward && HaveMemHier) {
+        /* leaves out the accesses since the last detailed region */
+        fprintf(output, "%sif (!FASTFWD.detailed()) {\n", INDENT[1]);
+        EmitFastForwardCaches(output, 2, "set_statistics");
+        fprintf(output, "%s}\n", INDENT[1]);
+    }
     if (ACLongJmpStop)
         fprintf(output, "%slongjmp(ac_env, AC_ACTION_STOP);\n", INDENT[1]);
     fprintf(output, "}\n\n");
@@ -2319,6 +2858,29 @@ void CreateProcessorImpl() {
     fprintf(output, "%sac_arch<%s_parms::ac_word, %s_parms::ac_Hword>::PrintStat();\n", 
             INDENT[1], project_name, project_name);
 
+    if (ACSparseDecCache)
+        fprintf(output, "%sDEC_CACHE.print_statistics(std::cerr);\n", INDENT[1]);
+
+    if (ACPersistDecCache) {
+        fprintf(output, "%sif (DEC_FILE.enabled())\n", INDENT[1]);
+        fprintf(output, "%sDEC_FILE.print_statistics(std::cerr);\n", INDENT[2]);
+    }
+
+    if (ACBlockCache)
+        fprintf(output, "%sBB.print_statistics(std::cerr);\n", INDENT[1]);
+
+    if (ACCallThread)
+        fprintf(output, "%sCT.print_statistics(std::cerr);\n", INDENT[1]);
+
+    if (ACHostCost)
+        fprintf(output, "%sHOSTCOST.print_statistics(std::cerr);\n", INDENT[1]);
+
+    if (ACFastForward)
+        fprintf(output, "%sFASTFWD.print_statistics(std::cerr, ac_instr_counter);\n", INDENT[1]);
+
+    if (ACCheckpoint)
+        fprintf(output, "%sCKP.print_statistics(std::cerr);\n", INDENT[1]);
+
 
 
     if (HaveMemHier) {
@@ -2340,13 +2902,53 @@ void CreateProcessorImpl() {
 
     fprintf(output, "}\n\n");
 
+    if (ACIntervalStats)
+        EmitIntervalSample(output);
+
+    if (ACFastForward)
+        EmitFastForwardSwitch(output);
+
+    if (ACCheckpoint)
+        EmitCheckpoint(output);
+
+    if (ACSelfModCode) {
+        /* invalidate_dec_cache() */
+        unsigned step = ACIndexFix ? largest_format_size / 8 : 1;
+
+        fprintf(output, "// Invalidates decoded instructions overlapping [address, address + size)\n");
+        fprintf(output, "void %s::invalidate_dec_cache(unsigned address, unsigned size) {\n", project_name);
+        /* an instruction starting before address may still overlap it */
+        fprintf(output, "%sunsigned first = (address > %d) ? address - %d : 0;\n", 
+                INDENT[1], largest_format_size / 8 - 1, largest_format_size / 8 - 1);
+        fprintf(output, "%sunsigned last = address + size;\n", INDENT[1]);
+        fprintf(output, "%sif (last > dec_cache_size) last = dec_cache_size;\n\n", INDENT[1]);
+        if (step > 1)
+            fprintf(output, "%sfor (unsigned addr = first - first %% %d; addr < last; addr += %d) {\n", 
+                    INDENT[1], step, step);
+        else
+            fprintf(output, "%sfor (unsigned addr = first; addr < last; addr++) {\n", INDENT[1]);
+        fprintf(output, "%sDecCacheItem* dec = ", INDENT[2]);
+        EmitDecCacheEntry(output, "addr", 1);
+        fprintf(output, ";\n");
+        /* entries with id 0 hold the syscall routines */
+        if (ACSparseDecCache)
+            fprintf(output, "%sif (dec && dec->id) dec->valid = false;\n", INDENT[2]);
+        else
+            fprintf(output, "%sif (dec->id) dec->valid = false;\n", INDENT[2]);
+        fprintf(output, "%s}\n", INDENT[1]);
+        /* blocks hold the routines of the entries */
+        if (ACBlockCache)
+            fprintf(output, "%sBB.leave();\n", INDENT[1]);
+        fprintf(output, "}\n\n");
+    }
+
     if (ACWaitFlag) {
         /* set_proc_freq() */
         fprintf(output, "// Assigns value to processor frequency and updates cycle time values\n");
         fprintf(output, "void %s::set_proc_freq(unsigned int proc_freq) {\n", project_name);
         fprintf(output, "%sac_module::set_proc_freq(proc_freq);\n", INDENT[1]);
 
-        for(int cycles=1; cycles<=5; cycles++) {
+        for(int cycles=1; cycles<=5 && !ACIntCycles; cycles++) {
             for (ac_dec_instr *pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
                 if (pinstr->cycles == cycles) {
                     fprintf(output, "%stime_%dcycle=sc_time(%d*module_period_ns, SC_NS);\n", INDENT[1], cycles, cycles);
@@ -2365,9 +2967,14 @@ void CreateProcessorImpl() {
         fprintf(output, "%sgdbstub->set_port(port);\n", INDENT[1]);
         fprintf(output, "%sgdbstub->enable();\n", INDENT[1]);
         fprintf(output, "%sgdbstub->connect();\n", INDENT[1]);
+        if (ACGDBPatch)
+            fprintf(output, "%sgdb_step = gdbstub->stepping();\n", INDENT[1]);
         fprintf(output, "}\n\n");
     }
 
+    if (ACGDBPatch)
+        EmitGDBBreak(output, 0);
+
     //!END OF FILE.
     fclose(output);
     free(filename);
@@ -2597,6 +3204,12 @@ void CreateMainTmpl() {
   fprintf( output, "%sac_close_trace();\n", INDENT[1]);
   fprintf( output, "#endif \n\n");
 
+  if (ACBinTrace) {
+    fprintf( output, "#ifdef AC_BIN_TRACE\n");
+    fprintf( output, "%sac_bin_trace.close();\n", INDENT[1]);
+    fprintf( output, "#endif \n\n");
+  }
+
   fprintf( output, "%sreturn %s_proc1.ac_exit_status;\n", 
            INDENT[1], project_name);
 
@@ -3252,7 +3865,8 @@ void CreateMakefile(){
   fprintf( output, "LIB_ARCHC := `pkg-config --libs archc`\n");
   fprintf( output, "LIB_POWERSC := %s\n", (ACPowerEnable) ? "`pkg-config --libs powersc`" : "");
   fprintf( output, "LIB_DWARF := %s\n", (ACHLTraceFlag) ? "-ldw -lelf" : "" );
-  fprintf( output, "LIBS := $(LIB_SYSTEMC) $(LIB_ARCHC) $(LIB_POWERSC) $(LIB_DWARF) -lm $(EXTRA_LIBS)\n");
+  fprintf( output, "LIBS := $(LIB_SYSTEMC) $(LIB_ARCHC) $(LIB_POWERSC) $(LIB_DWARF) -lm%s $(EXTRA_LIBS)\n",
+           (ACPlugins) ? " -ldl" : "");
   fprintf( output, "CC :=  %s", CC_PATH);
   fprintf( output, "OPT :=  %s", OPT_FLAGS);
   fprintf( output, "DEBUG :=  %s", DEBUG_FLAGS);
@@ -3266,6 +3880,10 @@ void CreateMakefile(){
   if ( ac_match_endian )
     fprintf( output, " -DAC_MATCH_ENDIANNESS");
 
+  //!< Full decode runs on several host threads, the traces are written by one
+  if ( ACFullDecode || ACHLTraceFlag || ACBinTrace )
+    fprintf( output, " -pthread");
+
   fprintf( output, " %s", OTHER_FLAGS);
 
   fprintf( output, "CFLAGS := $(DEBUG) $(OPT) $(OTHER) %s %s\n",
@@ -3495,9 +4113,13 @@ void EmitUpdateMethod( FILE *output, int base_indent ) {
     }
   }*/
   
-  if (ACWaitFlag) {
+  /* with integer cycles the quantum is checked by control flow instructions */
+  if (ACWaitFlag && !ACIntCycles) {
     fprintf(output, "%sif (ac_qk.need_sync()) {\n", INDENT[base_indent]);
     fprintf(output, "%sac_qk.sync();\n", INDENT[base_indent + 1]);
+    if (ACIntervalStats)
+      fprintf(output, "%sif (sc_time_stamp().to_seconds() * 1e9 >= INTERVALS.next_ns) interval_sample();\n", 
+              INDENT[base_indent + 1]);
     fprintf(output, "%s}\n", INDENT[base_indent]);
   }
 }
@@ -3541,49 +4163,90 @@ void EmitDecodification( FILE *output, int base_indent) {
   //}
 
   if( ACDecCacheFlag ){
-    fprintf( output, "%sinstr_dec = (DEC_CACHE + (", INDENT[base_indent]);
-    if (ACFullDecode)
-      fprintf( output, "decode_pc");
-    else
-      fprintf( output, "ac_pc");
-    
-    if( ACIndexFix ) 
-      fprintf( output, " / %d", largest_format_size / 8);
-    fprintf( output, "));\n");
+    fprintf( output, "%sinstr_dec = ", INDENT[base_indent]);
+    EmitDecCacheEntry( output, ACFullDecode ? "decode_pc" : "ac_pc", 0);
+    fprintf( output, ";\n");
     
     if( !ACFullDecode ) {
       fprintf( output, "%sif ( !instr_dec->valid ){\n", INDENT[base_indent]);
       base_indent++;
     }
     
-    fprintf( output, "%sunsigned* ins_cache;\n", INDENT[base_indent]);
+    if( !ACInlineDecoder )
+      fprintf( output, "%sunsigned* ins_cache;\n", INDENT[base_indent]);
   }
   
   if( !ACFullDecode )
     fprintf( output, "%sdecode_pc = ac_pc;\n", INDENT[base_indent]);
   
-  fprintf( output, "%squant = 0;\n", INDENT[base_indent]);
-  fprintf( output, "%sins_cache = (ISA.decoder)->Decode(reinterpret_cast<unsigned char*>(buffer), quant);\n", 
-           INDENT[base_indent]);
+  /* Full decode runs in predecode(), where the decoding state is local */
+  if( ACInlineDecoder )
+    fprintf( output, "%sinstr_dec->id = decode_instr(instr_dec, buffer, decode_pc);\n", 
+             INDENT[base_indent]);
+  else {
+    fprintf( output, "%squant = 0;\n", INDENT[base_indent]);
+    if( ACFullDecode )
+      fprintf( output, "%sins_cache = (ISA.decoder)->Decode(reinterpret_cast<unsigned char*>(buffer), quant, &worker, worker.values);\n", 
+               INDENT[base_indent]);
+    else
+      fprintf( output, "%sins_cache = (ISA.decoder)->Decode(reinterpret_cast<unsigned char*>(buffer), quant);\n", 
+               INDENT[base_indent]);
+  }
   
   if( ACDecCacheFlag ){
     if( ACFullDecode ) {
-      fprintf( output, "%sif( ins_cache ) {\n", 
-               INDENT[base_indent]);
+      fprintf( output, "%sif( %s ) {\n", INDENT[base_indent],
+               ACInlineDecoder ? "instr_dec->id" : "ins_cache");
       base_indent++;
     }
     else
       fprintf( output, "%sinstr_dec->valid = true;\n", 
                INDENT[base_indent]);
+
+    /* predecode() threads add up their counts at the end */
+    if( ACPersistDecCache )
+      fprintf( output, "%s%s++;\n", INDENT[base_indent], 
+               ACFullDecode ? "decoded" : "DEC_FILE.decoded");
+
+    if( ACSelfModCode ) {
+      fprintf( output, "%sset_code_page(decode_pc);\n", INDENT[base_indent]);
+      fprintf( output, "%sset_code_page(decode_pc + %d);\n", 
+               INDENT[base_indent], largest_format_size / 8 - 1);
+    }
       
-    fprintf( output, "%sinstr_dec->id = ins_cache ? ins_cache[IDENT]: 0;\n", 
-             INDENT[base_indent]);
+    if( !ACInlineDecoder )
+      fprintf( output, "%sinstr_dec->id = ins_cache ? ins_cache[IDENT]: 0;\n", 
+               INDENT[base_indent]);
     
     if (ACThreading)
       fprintf( output, "%sinstr_dec->end_rot = IntRoutine[instr_dec->id];\n", 
                INDENT[base_indent]);
+
+    if (ACGDBPatch)
+      fprintf( output, "%sif (instr_dec->id && gdbstub->breakpoint(decode_pc)) instr_dec->end_rot = BreakEntry;\n", 
+               INDENT[base_indent]);
+
+    if (ACPlugins)
+      fprintf( output, "%sif (PLUGINS.active() && PLUGINS.decoded(decode_pc, instr_dec->id)) instr_dec->end_rot = PluginEntry;\n", 
+               INDENT[base_indent]);
     
-    EmitDecCacheAt( output, base_indent);
+    /* decode_instr() already filled the format fields */
+    if( !ACInlineDecoder )
+      EmitDecCacheAt( output, base_indent);
+    else if( !ACFullDecode ) {
+      fprintf( output, "%sif( !instr_dec->id ) {\n", INDENT[base_indent]);
+      fprintf( output, "%scerr << \"ArchC Error: Unidentified instruction. \" << endl;\n", 
+               INDENT[base_indent + 1]);
+      fprintf( output, "%scerr << \"PC = \" << hex << ac_pc << dec << endl;\n", 
+               INDENT[base_indent + 1]);
+      fprintf( output, "%sstop();\n", INDENT[base_indent + 1]);
+      if (ACThreading)
+        fprintf( output, "%slongjmp(ac_env, AC_ACTION_STOP);\n", 
+                 INDENT[base_indent + 1]);
+      else 
+        fprintf( output, "%sreturn;\n", INDENT[base_indent + 1]);
+      fprintf( output, "%s}\n", INDENT[base_indent]);
+    }
     
     base_indent--;
     fprintf( output, "%s}\n", INDENT[base_indent]);
@@ -3622,7 +4285,8 @@ void EmitInstrExecIni( FILE *output, int base_indent) {
   ac_dec_format *pformat;
   ac_dec_field *pfield;
   
-  if( ACGDBIntegrationFlag )
+  /* otherwise dispatch() routes breakpoints and steps to I_Break */
+  if( ACGDBIntegrationFlag && !ACGDBPatch )
     fprintf( output, "%sif (gdbstub && gdbstub->stop(ac_pc)) gdbstub->process_bp();\n\n", 
              INDENT[base_indent]);
 
@@ -3654,135 +4318,299 @@ void EmitInstrExecIni( FILE *output, int base_indent) {
 
 
 /**************************************/
-/*!  Emit code for executing instructions
-  \brief Used by EmitProcessorBhv function */
+/*!  Emits the behavior method calls of one instruction and the time
+  it takes. The generic instruction behavior is part of the dispatch
+  unless threading with an ABI.
+  \brief Used by EmitInstrExec and EmitCallThread functions */
 /***************************************/
-void EmitInstrExec( FILE *output, int base_indent){
-    extern ac_dec_instr *instr_list;
+void EmitInstrBehavior( FILE *output, ac_dec_instr *pinstr, int base_indent, int timed){
+    extern ac_dec_field *common_instr_field_list;
     extern ac_dec_format *format_ins_list;
     extern char* project_name;
 
     ac_dec_format *pformat;
-    ac_dec_instr *pinstr;
     ac_dec_field *pfield;
 
-    if( ACThreading ) {
-        fprintf(output, "%sI_Init:\n", INDENT[base_indent]);
-        fprintf(output, "%sgoto *dispatch();\n\n", INDENT[base_indent + 1]);
-
-        if ( ACABIFlag && ACDecCacheFlag ) {
-            fprintf( output, "%s#define AC_SYSC(NAME,LOCATION) \\\n", 
-                    INDENT[base_indent]);
-            fprintf( output, "%sSys_##LOCATION: \\\n", INDENT[base_indent]);
-            base_indent++;
-
-            if( ACStatsFlag ){
-                fprintf( output, "%sISA.stats[%s_stat_ids::SYSCALLS]++; \\\n", 
-                        INDENT[base_indent], project_name);
+    for (pformat = format_ins_list;
+            (pformat != NULL) && strcmp(pinstr->format, pformat->name);
+            pformat = pformat->next);
+
+    if ( ACCallGraph && pinstr->cflow && pinstr->cflow->target )
+        EmitCallGraphBranch(output, pinstr, pformat, base_indent);
+
+    /* t0 to t3 bracket the generic, format and instruction behaviors */
+    if ( timed && ACABIFlag )
+        fprintf(output, "%suint64_t t0 = ac_host_cost::now();\n", INDENT[base_indent]);
+
+    if ( ACThreading && ACABIFlag ) {
+        fprintf(output, "%sISA._behavior_instruction(", INDENT[base_indent]);
+        /* common_instr_field_list has the list of fields for the generic instruction. */
+        if( ACDecCacheFlag ){
+            for( pfield = common_instr_field_list; 
+                    pfield != NULL; pfield = pfield->next) {
+                fprintf(output, "instr_dec->F_%s.%s", pformat->name, pfield->name);
+                if (pfield->next != NULL)
+                    fprintf(output, ", ");
             }
+        }
+        else {
+            for( pfield = common_instr_field_list; 
+                    pfield != NULL; pfield = pfield->next){
+                fprintf(output, "ins_cache[%d]", pfield->id);
+                if (pfield->next != NULL)
+                    fprintf(output, ", ");
+            }
+        }
+        fprintf(output, ");\n");
+    }
 
-            fprintf( output, "%sISA.syscall.NAME(); \\\n", INDENT[base_indent]);
-            fprintf( output, "%sgoto *dispatch();\n\n", INDENT[base_indent]);
-            base_indent--;
+    if ( timed )
+        fprintf(output, "%suint64_t t1 = ac_host_cost::now();\n", INDENT[base_indent]);
 
-            fprintf( output, "%s#include <ac_syscall.def>\n", INDENT[base_indent]);
-            fprintf( output, "%s#undef AC_SYSC\n\n", INDENT[base_indent]);
-        }
+    /* emits format behavior method call */
+    fprintf(output, "%sISA._behavior_%s_%s(", INDENT[base_indent],
+            project_name, pformat->name);
+    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
+        if( ACDecCacheFlag )
+            fprintf(output, "instr_dec->F_%s.%s", pformat->name, pfield->name);
+        else
+            fprintf(output, "ins_cache[%d]", pfield->id);
+        if (pfield->next != NULL)
+            fprintf(output, ", ");
     }
-    else {
+    fprintf(output, ");\n");
 
-        if( ACDebugFlag ){
-            fprintf( output, "%sif( ac_do_trace != 0 ) \n", INDENT[base_indent]);
-            fprintf( output, PRINT_TRACE, INDENT[base_indent+1]);
-            fprintf( output, "\n");
-        }
-        if( ACHLTraceFlag)
-        {
-          fprintf( output, "%sgenerate_trace_for_address(ac_pc);\\\n", INDENT[base_indent]);
-        }
+    if ( timed )
+        fprintf(output, "%suint64_t t2 = ac_host_cost::now();\n", INDENT[base_indent]);
 
-        EmitInstrExecIni( output, base_indent );
+    /* emits instruction behavior method call */
+    fprintf(output, "%sISA.behavior_%s(", INDENT[base_indent],
+            pinstr->name);
+    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
+        if( ACDecCacheFlag )
+            fprintf(output, "instr_dec->F_%s.%s", pformat->name, pfield->name);
+        else
+            fprintf(output, "ins_cache[%d]", pfield->id);
+        if (pfield->next != NULL)
+            fprintf(output, ", ");
+    }
+    fprintf(output, ");\n");
 
-        /* Switch statement for instruction selection */
-        fprintf(output, "%sswitch (ins_id) {\n", INDENT[base_indent]);
+    if ( timed ) {
+        fprintf(output, "%suint64_t t3 = ac_host_cost::now();\n", INDENT[base_indent]);
+        fprintf(output, "%sHOSTCOST.behaviors(%d, %d, %st2 - t1, t3 - t2);\n", INDENT[base_indent],
+                pinstr->id, pformat->id, ACABIFlag ? "t1 - t0, " : "");
     }
 
-    for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
-        if( ACThreading ) {
-            fprintf(output, "%sI_%s: // Instruction %s\n", 
-                    INDENT[base_indent], pinstr->name, pinstr->name);
-            if ( ACABIFlag ) {
-                fprintf(output, "%sISA._behavior_instruction(", INDENT[base_indent + 1]);
-                /* common_instr_field_list has the list of fields for the generic instruction. */
-                if( ACDecCacheFlag ){
-                    for (pformat = format_ins_list;
-                            (pformat != NULL) && strcmp(pinstr->format, pformat->name);
-                            pformat = pformat->next);
-                    for( pfield = common_instr_field_list; 
-                            pfield != NULL; pfield = pfield->next) {
-                        fprintf(output, "instr_dec->F_%s.%s", pformat->name, pfield->name);
-                        if (pfield->next != NULL)
-                            fprintf(output, ", ");
-                    }
-                }
-                else {
-                    for( pfield = common_instr_field_list; 
-                            pfield != NULL; pfield = pfield->next){
-                        fprintf(output, "ins_cache[%d]", pfield->id);
-                        if (pfield->next != NULL)
-                            fprintf(output, ", ");
-                    }
-                }
-                fprintf(output, ");\n");
+    if( ACIntCycles ) {
+      /* straight line code checks only now and then, in case the model
+         leaves the cflow attribute out of some jumps */
+      const char *every = pinstr->cflow || !HaveCflow() ? "" :
+                          "ac_instr_counter % AC_SYNC_CHECK_INSTRS == 0 && ";
+
+      fprintf(output, "%sac_pending_cycles += %d;\n", INDENT[base_indent], pinstr->cycles);
+      if( ACIntervalStats ) {
+        fprintf(output, "%sif (%sac_pending_cycles >= ac_sync_cycles) {\n", INDENT[base_indent], every);
+        fprintf(output, "%ssync_cycles();\n", INDENT[base_indent + 1]);
+        fprintf(output, "%sif (sc_time_stamp().to_seconds() * 1e9 >= INTERVALS.next_ns) interval_sample();\n", 
+                INDENT[base_indent + 1]);
+        fprintf(output, "%s}\n", INDENT[base_indent]);
+      }
+      else
+        fprintf(output, "%sif (%sac_pending_cycles >= ac_sync_cycles) sync_cycles();\n", 
+                INDENT[base_indent], every);
+    }
+    else if( ACWaitFlag ) {
+      if (pinstr->cycles <= 5)
+        fprintf(output, "%sac_qk.inc(time_%dcycle);\n", INDENT[base_indent], pinstr->cycles);
+      else
+        fprintf(output, "%sac_qk.inc(sc_time(module_period_ns*%d, SC_NS));\n", INDENT[base_indent], pinstr->cycles);
+    }
+}
+
+
+/**************************************/
+/*!  Tells whether identifier name appears in the C expression expr.
+  \brief Used by EmitCallGraphBranch function */
+/***************************************/
+static int ExprUses(const char *expr, const char *name) {
+  size_t len = strlen(name);
+  const char *p;
+
+  for (p = expr; (p = strstr(p, name)) != NULL; p += len)
+    if ((p == expr || !(isalnum(p[-1]) || p[-1] == '_' || p[-1] == '.')) &&
+        !(isalnum(p[len]) || p[len] == '_'))
+      return 1;
+  return 0;
+}
+
+/**************************************/
+/*!  Emits the report of a control flow instruction to the call graph:
+  when its cond holds, its target and the address past its delay slots.
+  Both are evaluated before any behavior runs, so ac_pc is the address
+  of the instruction, as in the is_jump/is_branch annotations, and the
+  fields they use are declared from the decoded instruction.
+  \brief Used by EmitInstrBehavior function */
+/***************************************/
+void EmitCallGraphBranch(FILE *output, ac_dec_instr *pinstr, ac_dec_format *pformat, int base_indent) {
+  ac_control_flow *cflow = pinstr->cflow;
+  const char *cond = cflow->cond ? cflow->cond : "1";
+  ac_dec_field *pfield;
+
+  fprintf(output, "%s{\n", INDENT[base_indent]);
+  for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
+    if (!ExprUses(cflow->target, pfield->name) && !ExprUses(cond, pfield->name))
+      continue;
+
+    fprintf(output, "%s%s", INDENT[base_indent + 1], pfield->sign ? "" : "u");
+    if (pfield->size < 9) fprintf(output, "int8_t");
+    else if (pfield->size < 17) fprintf(output, "int16_t");
+    else if (pfield->size < 33) fprintf(output, "int32_t");
+    else fprintf(output, "int64_t");
+
+    if( ACDecCacheFlag )
+      fprintf(output, " %s = instr_dec->F_%s.%s;\n", pfield->name, pformat->name, pfield->name);
+    else
+      fprintf(output, " %s = ins_cache[%d];\n", pfield->name, pfield->id);
+  }
+
+  if (strcmp(cond, "1"))
+    fprintf(output, "%sif (%s)\n%s", INDENT[base_indent + 1], cond, INDENT[base_indent + 2]);
+  else
+    fprintf(output, "%s", INDENT[base_indent + 1]);
+  fprintf(output, "CALLGRAPH.branch(ac_pc, (uint32_t) (%s), (uint32_t) ac_pc + %d, ac_instr_counter);\n",
+          cflow->target, pinstr->size * (1 + cflow->delay_slot));
+  fprintf(output, "%s}\n", INDENT[base_indent]);
+}
+
+
+/**************************************/
+/*!  Emit code for executing instructions
+  \brief Used by EmitProcessorBhv function */
+/***************************************/
+void EmitInstrExec( FILE *output, int base_indent){
+    extern ac_dec_instr *instr_list;
+    extern char* project_name;
+
+    ac_dec_instr *pinstr;
+
+    if( ACThreading ) {
+        fprintf(output, "%sI_Init:\n", INDENT[base_indent]);
+        fprintf(output, "%sgoto *dispatch();\n\n", INDENT[base_indent + 1]);
+
+        if ( ACBlockCache ) {
+            /* ac_pc left the block or ran past it; dispatch() also
+               records the instructions of new blocks */
+            fprintf(output, "%sI_BlockExit:\n", INDENT[base_indent]);
+            fprintf(output, "%sgoto *dispatch();\n\n", INDENT[base_indent + 1]);
+        }
+
+        if ( ACGDBPatch ) {
+            fprintf(output, "%sI_Break:\n", INDENT[base_indent]);
+            fprintf(output, "%sgoto *gdb_break();\n\n", INDENT[base_indent + 1]);
+        }
+
+        if ( ACPlugins ) {
+            fprintf(output, "%sI_Plugin:\n", INDENT[base_indent]);
+            fprintf(output, "%sPLUGINS.exec(ac_pc, instr_dec->id);\n", INDENT[base_indent + 1]);
+            fprintf(output, "%sgoto *IntRoutine[instr_dec->id];\n\n", INDENT[base_indent + 1]);
+        }
+
+        if ( ACCallThread ) {
+            /* the block does the dispatch work of each of its instructions */
+            fprintf(output, "%sI_CallThread:\n", INDENT[base_indent]);
+            fprintf(output, "%s((ac_call_thread::block_t) instr_dec->ct_block)(this);\n", 
+                    INDENT[base_indent + 1]);
+            fprintf(output, "%sgoto *dispatch();\n\n", INDENT[base_indent + 1]);
+        }
+
+        if ( ACABIFlag && ACDecCacheFlag ) {
+            fprintf( output, "%s#define AC_SYSC(NAME,LOCATION) \\\n", 
+                    INDENT[base_indent]);
+            fprintf( output, "%sSys_##LOCATION: \\\n", INDENT[base_indent]);
+            base_indent++;
+
+            /* dispatch() already counted the call */
+            if( ACCheckpoint )
+                EmitCheckpointSyscall(output, base_indent, "ac_instr_counter - 1");
+
+            if( ACStatsFlag && ACFastForward ){
+                fprintf( output, "%sif (FASTFWD.detailed()) ISA.stats[%s_stat_ids::SYSCALLS]++; \\\n", 
+                        INDENT[base_indent], project_name);
             }
+            else if( ACStatsFlag ){
+                fprintf( output, "%sISA.stats[%s_stat_ids::SYSCALLS]++; \\\n", 
+                        INDENT[base_indent], project_name);
+            }
+
+            if( ACPlugins )
+                fprintf( output, "%sif (PLUGINS.active()) PLUGINS.syscall(ac_pc, #NAME); \\\n", 
+                        INDENT[base_indent]);
+
+            /* ac_qk holds the time of every instruction before the call */
+            if( ACIntCycles )
+                fprintf( output, "%sflush_cycles(); \\\n", INDENT[base_indent]);
+            fprintf( output, "%sISA.syscall.NAME(); \\\n", INDENT[base_indent]);
+            fprintf( output, "%sgoto *dispatch();\n\n", INDENT[base_indent]);
+            base_indent--;
+
+            fprintf( output, "%s#include <ac_syscall.def>\n", INDENT[base_indent]);
+            fprintf( output, "%s#undef AC_SYSC\n\n", INDENT[base_indent]);
         }
+    }
+    else {
+
+        if( ACBinTrace )
+            fprintf( output, "%sac_bin_trace.instr(ac_pc, ins_id);\n\n", INDENT[base_indent]);
+        else if( ACDebugFlag ){
+            fprintf( output, "%sif( ac_do_trace != 0 ) \n", INDENT[base_indent]);
+            fprintf( output, PRINT_TRACE, INDENT[base_indent+1]);
+            fprintf( output, "\n");
+        }
+        if( ACHLTraceFlag)
+        {
+          fprintf( output, "%sgenerate_trace_for_address(ac_pc);\\\n", INDENT[base_indent]);
+        }
+        if( ACProfile )
+          fprintf( output, "%sPROFILE.tick(ac_pc);\n", INDENT[base_indent]);
+        if( ACIntervalStats )
+          fprintf( output, "%sif (ac_instr_counter >= INTERVALS.next_instr) interval_sample();\n", 
+                   INDENT[base_indent]);
+        /* the instruction is counted after its behavior */
+        if( ACBBV )
+          EmitBBVEnter(output, base_indent, "ac_instr_counter + 1");
+
+        EmitInstrExecIni( output, base_indent );
+
+        /* Switch statement for instruction selection */
+        fprintf(output, "%sswitch (ins_id) {\n", INDENT[base_indent]);
+    }
+
+    for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
+        if( ACThreading )
+            fprintf(output, "%sI_%s: // Instruction %s\n", 
+                    INDENT[base_indent], pinstr->name, pinstr->name);
         else
             /* opens case statement */
             fprintf(output, "%scase %d: // Instruction %s\n", 
                     INDENT[base_indent], pinstr->id, pinstr->name);
 
-        /* emits format behavior method call */
-        for (pformat = format_ins_list;
-                (pformat != NULL) && strcmp(pinstr->format, pformat->name);
-                pformat = pformat->next);
-        fprintf(output, "%sISA._behavior_%s_%s(", INDENT[base_indent + 1],
-                project_name, pformat->name);
-        for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
-            if( ACDecCacheFlag )
-                fprintf(output, "instr_dec->F_%s.%s", pformat->name, pfield->name);
-            else
-                fprintf(output, "ins_cache[%d]", pfield->id);
-            if (pfield->next != NULL)
-                fprintf(output, ", ");
-        }
-        fprintf(output, ");\n");
+        EmitInstrBehavior(output, pinstr, base_indent + 1, 0);
 
-        /* emits instruction behavior method call */
-        fprintf(output, "%sISA.behavior_%s(", INDENT[base_indent + 1],
-                pinstr->name);
-        for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
-            if( ACDecCacheFlag )
-                fprintf(output, "instr_dec->F_%s.%s", pformat->name, pfield->name);
+        if( ACThreading ) {
+            /* control flow instructions end the basic block */
+            if( ACBlockCache && pinstr->cflow == NULL )
+                fprintf(output, "%sgoto *dispatch_block();\n\n", INDENT[base_indent + 1]);
             else
-                fprintf(output, "ins_cache[%d]", pfield->id);
-            if (pfield->next != NULL)
-                fprintf(output, ", ");
-        }
-        fprintf(output, ");\n");
-
-        if( ACWaitFlag ) {
-          if (pinstr->cycles <= 5)
-            fprintf(output, "%sac_qk.inc(time_%dcycle);\n", INDENT[base_indent + 1], pinstr->cycles);
-          else
-            fprintf(output, "%sac_qk.inc(sc_time(module_period_ns*%d, SC_NS));\n", INDENT[base_indent + 1], pinstr->cycles);
+                fprintf(output, "%sgoto *dispatch();\n\n", INDENT[base_indent + 1]);
         }
-
-        if( ACThreading )
-            fprintf(output, "%sgoto *dispatch();\n\n", INDENT[base_indent + 1]);
         else
             fprintf(output, "%sbreak;\n", INDENT[base_indent]);
     }
 
+    if( ACHostCost )
+        EmitHostCostExec(output, base_indent);
+
     if( !ACThreading ) {
         fprintf(output, "%s} // switch (ins_id)\n", INDENT[base_indent]);
 
@@ -3799,6 +4627,356 @@ void EmitInstrExec( FILE *output, int base_indent){
 }
 
 
+/**************************************/
+/*!  Emits I_HostCost, the routine dispatch() returns for sampled
+  instructions: the behaviors of the instruction bracketed by host time
+  stamps, then the dispatch of the next one, also timed. Other entries,
+  such as the syscalls, run their own routine unmeasured.
+  \brief Used by EmitInstrExec function */
+/***************************************/
+void EmitHostCostExec(FILE *output, int base_indent) {
+    extern ac_dec_instr *instr_list;
+    ac_dec_instr *pinstr;
+
+    fprintf(output, "%sI_HostCost:\n", INDENT[base_indent]);
+    fprintf(output, "%sswitch (instr_dec->id) {\n", INDENT[base_indent + 1]);
+    for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
+        fprintf(output, "%scase %d: { // Instruction %s\n", 
+                INDENT[base_indent + 1], pinstr->id, pinstr->name);
+        EmitInstrBehavior(output, pinstr, base_indent + 2, 1);
+        fprintf(output, "%sbreak;\n", INDENT[base_indent + 2]);
+        fprintf(output, "%s}\n", INDENT[base_indent + 1]);
+    }
+    fprintf(output, "%sdefault:\n", INDENT[base_indent + 1]);
+    fprintf(output, "%sgoto *instr_dec->end_rot;\n", INDENT[base_indent + 2]);
+    fprintf(output, "%s}\n", INDENT[base_indent + 1]);
+    fprintf(output, "%s{\n", INDENT[base_indent + 1]);
+    fprintf(output, "%suint64_t t0 = ac_host_cost::now();\n", INDENT[base_indent + 2]);
+    fprintf(output, "%svoid* next = dispatch();\n", INDENT[base_indent + 2]);
+    fprintf(output, "%sHOSTCOST.dispatch(ac_host_cost::now() - t0);\n", INDENT[base_indent + 2]);
+    fprintf(output, "%sgoto *next;\n", INDENT[base_indent + 2]);
+    fprintf(output, "%s}\n\n", INDENT[base_indent + 1]);
+}
+
+
+/**************************************/
+/*!  Emits the list of counters written by the interval statistics and
+  the call starting them: the syscalls, the executions of each
+  instruction and the accesses of each cache.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitIntervalOpen(FILE *output, int base_indent) {
+  extern ac_dec_instr *instr_list;
+  extern ac_sto_list *storage_list;
+  extern int HaveMemHier;
+  static const char *cache_counters[] = {"read_hit", "read_miss", "write_hit", "write_miss", "evictions"};
+  ac_dec_instr *pinstr;
+  ac_sto_list *pstorage;
+  unsigned count = 1, i;
+
+  fprintf(output, "%sstatic const char* const interval_columns[] = {\n", INDENT[base_indent]);
+  fprintf(output, "%s\"syscalls\"", INDENT[base_indent + 2]);
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next, count++)
+    fprintf(output, ", \"%s\"", pinstr->name);
+  if (HaveMemHier) {
+    for (pstorage = storage_list; pstorage != NULL; pstorage = pstorage->next) {
+      if (pstorage->type != CACHE && pstorage->type != ICACHE && pstorage->type != DCACHE)
+        continue;
+      for (i = 0; i < 5; i++, count++)
+        fprintf(output, ",\n%s\"%s.%s\"", INDENT[base_indent + 2], pstorage->name, cache_counters[i]);
+    }
+  }
+  fprintf(output, "};\n");
+  fprintf(output, "%sINTERVALS.open(name(), interval_columns, %u, ac_interval, ac_interval_ns, ac_interval_file);\n\n", 
+          INDENT[base_indent], count);
+}
+
+/**************************************/
+/*!  Emits interval_sample(), which reads the counters listed by
+  EmitIntervalOpen into the row of the interval ending now.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitIntervalSample(FILE *output) {
+  extern ac_dec_instr *instr_list;
+  extern ac_sto_list *storage_list;
+  extern int HaveMemHier;
+  extern char* project_name;
+  ac_dec_instr *pinstr;
+  ac_sto_list *pstorage;
+  unsigned count = 1;
+
+  fprintf(output, "// Writes the counters of the interval ending now\n");
+  fprintf(output, "void %s::interval_sample() {\n", project_name);
+  fprintf(output, "%sif (!INTERVALS.active())\n", INDENT[1]);
+  fprintf(output, "%sreturn;\n\n", INDENT[2]);
+  fprintf(output, "%sunsigned long long* row = INTERVALS.row();\n", INDENT[1]);
+  fprintf(output, "%srow[0] = ISA.stats[%s_stat_ids::SYSCALLS];\n", INDENT[1], project_name);
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next, count++)
+    fprintf(output, "%srow[%u] = (*(ISA.instr_stats[%d]))[%s_instr_stat_ids::COUNT];\n", 
+            INDENT[1], count, pinstr->id, project_name);
+  if (HaveMemHier) {
+    fprintf(output, "%scache_statistics cache;\n", INDENT[1]);
+    for (pstorage = storage_list; pstorage != NULL; pstorage = pstorage->next) {
+      if (pstorage->type != CACHE && pstorage->type != ICACHE && pstorage->type != DCACHE)
+        continue;
+      fprintf(output, "%s%s.get_statistics(&cache);\n", INDENT[1], pstorage->name);
+      fprintf(output, "%srow[%u] = cache.read_hit;\n", INDENT[1], count++);
+      fprintf(output, "%srow[%u] = cache.read_miss;\n", INDENT[1], count++);
+      fprintf(output, "%srow[%u] = cache.write_hit;\n", INDENT[1], count++);
+      fprintf(output, "%srow[%u] = cache.write_miss;\n", INDENT[1], count++);
+      fprintf(output, "%srow[%u] = cache.evictions;\n", INDENT[1], count++);
+    }
+  }
+  fprintf(output, "%sINTERVALS.sample(ac_instr_counter, sc_time_stamp().to_seconds() * 1e9);\n", INDENT[1]);
+  fprintf(output, "}\n\n");
+}
+
+
+/**************************************/
+/*!  Emits the basic block vector update of the instruction at ac_pc,
+  which enters a block unless it follows the previous instruction.
+  count is the instruction counter including this instruction.
+  \brief Used by the dispatch functions */
+/***************************************/
+void EmitBBVEnter(FILE *output, int base_indent, const char *count) {
+  extern ac_dec_instr *instr_list;
+  ac_dec_instr *pinstr;
+  int size = instr_list ? instr_list->size : 0;
+
+  /* models with a single instruction size skip the table */
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next)
+    if (pinstr->size != size)
+      size = -1;
+
+  fprintf(output, "%sif (ac_pc != BBV.next_pc) BBV.enter(instr_dec->bbv_id, ac_pc, %s);\n", 
+          INDENT[base_indent], count);
+  if (size > 0)
+    fprintf(output, "%sBBV.next_pc = ac_pc + %d;\n", INDENT[base_indent], size);
+  else
+    fprintf(output, "%sBBV.next_pc = ac_pc + ISA.instr_table[ins_id].ac_instr_size;\n", 
+            INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Emits a call to method of every cache with its statistics of the
+  detailed regions: get_statistics saves them, set_statistics puts them
+  back, dropping the accesses made since.
+  \brief Used by CreateProcessorImpl and EmitFastForwardSwitch functions */
+/***************************************/
+void EmitFastForwardCaches(FILE *output, int base_indent, const char *method) {
+  extern ac_sto_list *storage_list;
+  extern int HaveMemHier;
+  ac_sto_list *pstorage;
+
+  if (!HaveMemHier)
+    return;
+  for (pstorage = storage_list; pstorage != NULL; pstorage = pstorage->next)
+    if (pstorage->type == CACHE || pstorage->type == ICACHE || pstorage->type == DCACHE)
+      fprintf(output, "%s%s.%s(&%s_detail);\n", INDENT[base_indent], 
+              pstorage->name, method, pstorage->name);
+}
+
+/**************************************/
+/*!  Emits fast_forward_switch(), called by the dispatch functions when
+  a detailed region ends or starts. Caches stay in the memory hierarchy
+  outside the regions, which keeps them warm, but their statistics are
+  put back as they were at the end of the last region.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitFastForwardSwitch(FILE *output) {
+  extern char* project_name;
+
+  fprintf(output, "// Switches between the functional and the detailed dispatch\n");
+  fprintf(output, "void %s::fast_forward_switch() {\n", project_name);
+  fprintf(output, "%sif (FASTFWD.detailed()) {\n", INDENT[1]);
+  fprintf(output, "%sFASTFWD.leave(ac_instr_counter);\n", INDENT[2]);
+  EmitFastForwardCaches(output, 2, "get_statistics");
+  fprintf(output, "%s}\n", INDENT[1]);
+  fprintf(output, "%selse {\n", INDENT[1]);
+  fprintf(output, "%sFASTFWD.enter(ac_instr_counter);\n", INDENT[2]);
+  EmitFastForwardCaches(output, 2, "set_statistics");
+  fprintf(output, "%s}\n", INDENT[1]);
+  fprintf(output, "}\n\n");
+}
+
+/**************************************/
+/*!  Emits dispatch_fast(), the functional Dispatch Function used outside
+  the detailed regions of --fast-forward. It decodes the instruction and
+  returns its interpretation routine, without the statistics, traces
+  and power estimation of dispatch(). It still synchronizes with SystemC
+  at the end of each quantum, so other modules are not starved while the
+  core fast-forwards. When a trigger
+  starts a region it returns NULL, and dispatch() goes on with the same
+  instruction.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitFastDispatch(FILE *output, int base_indent) {
+  extern char* project_name;
+
+  fprintf( output, "%svoid* %s::dispatch_fast() {\n", 
+           INDENT[base_indent], project_name);
+  base_indent++;
+
+  if (!ACLongJmpStop)
+    fprintf( output, "%sif (ac_stop_flag) longjmp(ac_env, AC_ACTION_STOP);\n\n", 
+             INDENT[base_indent]);
+
+  /* with integer cycles the quantum is checked by control flow instructions */
+  if (ACWaitFlag && !ACIntCycles)
+    fprintf( output, "%sif (ac_qk.need_sync()) ac_qk.sync();\n", INDENT[base_indent]);
+
+  EmitFetchInit(output, base_indent);
+  fprintf( output, "%sunsigned ins_id;\n", INDENT[base_indent]);
+
+  if( ACFullDecode ) {
+    fprintf( output, "%sinstr_dec = ", INDENT[base_indent]);
+    EmitDecCacheEntry( output, "ac_pc", 0);
+    fprintf( output, ";\n");
+    fprintf( output, "%sins_id = instr_dec->id;\n\n", INDENT[base_indent]);
+  }
+  else EmitDecodification(output, base_indent);
+
+  fprintf( output, "%sif (ac_instr_counter >= FASTFWD.detail_at || ac_pc == FASTFWD.detail_pc ||\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%sins_id == FASTFWD.detail_instr) {\n", INDENT[base_indent + 2]);
+  fprintf( output, "%sfast_forward_switch();\n", INDENT[base_indent + 1]);
+  fprintf( output, "%sreturn NULL;\n", INDENT[base_indent + 1]);
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+
+  fprintf( output, "%sac_instr_counter++;\n", INDENT[base_indent]);
+  if( ACBBV )
+    EmitBBVEnter(output, base_indent, "ac_instr_counter");
+  EmitInstrExecIni(output, base_indent);
+  fprintf( output, "%sreturn instr_dec->end_rot;\n", INDENT[base_indent]);
+
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Emits the sections of a checkpoint, in the same order for
+  checkpoint_save() (dir "put") and checkpoint_restore() (dir "get"):
+  pc, registers, register banks and memories as declared, then the heap
+  pointer and cycle counter. Memories behind TLM ports belong to the
+  platform and are left out.
+  \brief Used by EmitCheckpoint function */
+/***************************************/
+void EmitCheckpointState(FILE *output, const char *dir) {
+  extern ac_sto_list *storage_list;
+  extern ac_dec_format *format_reg_list;
+  ac_sto_list *pstorage;
+  ac_dec_format *pformat;
+  ac_dec_field *pfield;
+
+  fprintf(output, "%sCKP.%s_reg(\"ac_pc\", ac_pc);\n", INDENT[1], dir);
+
+  for (pstorage = storage_list; pstorage != NULL; pstorage = pstorage->next) {
+    switch (pstorage->type) {
+      case REG:
+        if (pstorage->format == NULL) {
+          fprintf(output, "%sCKP.%s_reg(\"%s\", %s);\n", INDENT[1], dir, 
+                  pstorage->name, pstorage->name);
+          break;
+        }
+        for (pformat = format_reg_list; pformat != NULL; pformat = pformat->next)
+          if (!strcmp(pformat->name, pstorage->format))
+            break;
+        for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next)
+          fprintf(output, "%sCKP.%s_reg(\"%s.%s\", %s.%s);\n", INDENT[1], dir, 
+                  pstorage->name, pfield->name, pstorage->name, pfield->name);
+        break;
+
+      case REGBANK:
+        fprintf(output, "%sCKP.%s(\"%s\", %s.Data, sizeof(%s.Data));\n", INDENT[1], dir, 
+                pstorage->name, pstorage->name, pstorage->name);
+        break;
+
+      case MEM:
+      case CACHE:
+      case ICACHE:
+      case DCACHE:
+        fprintf(output, "%sCKP.%s_memory(\"%s\", %s.get_host_ptr(), %s.get_size());\n", 
+                INDENT[1], dir, pstorage->name, pstorage->name, pstorage->name);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  fprintf(output, "%sCKP.%s(\"ac_heap_ptr\", &ac_heap_ptr, sizeof(ac_heap_ptr));\n", INDENT[1], dir);
+  fprintf(output, "%sCKP.%s(\"ac_cycle_counter\", &ac_cycle_counter, sizeof(ac_cycle_counter));\n", 
+          INDENT[1], dir);
+}
+
+/**************************************/
+/*!  Emits checkpoint_save() and checkpoint_restore(). Memories are only
+  ac_storage objects here: a memory hierarchy disables --checkpoint.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitCheckpoint(FILE *output) {
+  extern char* project_name;
+
+  fprintf(output, "// Saves the state after count instructions to a checkpoint\n");
+  fprintf(output, "void %s::checkpoint_save(unsigned long long count) {\n", project_name);
+  fprintf(output, "%sstd::vector<Elf32_Addr> memmap;\n\n", INDENT[1]);
+  fprintf(output, "%sif (!CKP.begin_save(count))\n", INDENT[1]);
+  fprintf(output, "%sreturn;\n", INDENT[2]);
+  EmitCheckpointState(output, "put");
+  fprintf(output, "%sac_dyn_loader.mem_map.get_state(memmap);\n", INDENT[1]);
+  fprintf(output, "%sCKP.put(\"memmap\", &memmap[0], memmap.size() * sizeof(Elf32_Addr));\n", INDENT[1]);
+  fprintf(output, "%sCKP.put_files();\n", INDENT[1]);
+  fprintf(output, "%sCKP.end_save();\n", INDENT[1]);
+  fprintf(output, "}\n\n");
+
+  fprintf(output, "// Restores the state saved in checkpoint ac_restore_file\n");
+  fprintf(output, "void %s::checkpoint_restore() {\n", project_name);
+  fprintf(output, "%sconst Elf32_Addr* memmap;\n", INDENT[1]);
+  fprintf(output, "%ssize_t size;\n\n", INDENT[1]);
+  fprintf(output, "%sac_instr_counter = CKP.begin_restore(ac_restore_file);\n", INDENT[1]);
+  EmitCheckpointState(output, "get");
+  fprintf(output, "%smemmap = (const Elf32_Addr*) CKP.get(\"memmap\", size);\n", INDENT[1]);
+  fprintf(output, "%sac_dyn_loader.mem_map.set_state(memmap, size / sizeof(Elf32_Addr));\n", INDENT[1]);
+  fprintf(output, "%sCKP.get_files();\n", INDENT[1]);
+  fprintf(output, "%sCKP.end_restore();\n", INDENT[1]);
+  fprintf(output, "}\n\n");
+}
+
+/**************************************/
+/*!  Emits the --checkpoint-syscall trigger of a system call, as a line
+  of the AC_SYSC macro. count is the number of instructions run before
+  the call.
+  \brief Used by EmitInstrExec, EmitProcessorBhv and EmitDispatch functions */
+/***************************************/
+void EmitCheckpointSyscall(FILE *output, int base_indent, const char *count) {
+  fprintf(output, "%sif (CKP.syscall(#NAME)) checkpoint_save(%s); \\\n", 
+          INDENT[base_indent], count);
+}
+
+/**************************************/
+/*!  Emits the loading of the persistent decode cache and the full
+  decode of the program, ahead of the fork server when it is on.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitDecodeWarmup(FILE *output, int base_indent) {
+  extern char *project_name;
+  extern int largest_format_size;
+
+  if( ACPersistDecCache ) {
+    fprintf(output, "%sif (ac_dec_cache_dir)\n", INDENT[base_indent]);
+    fprintf(output, "%sload_dec_cache();\n\n", INDENT[base_indent + 1]);
+  }
+
+  if( ACFullDecode ) {
+    /* chunks cover whole sparse decode cache pages */
+    if( ACPersistDecCache )
+      fprintf(output, "%sif (!DEC_FILE.hit())\n%s", INDENT[base_indent], INDENT[base_indent]);
+    fprintf(output, "%spredecode_parallel(this, &%s::predecode, ac_pc, dec_cache_size, %d, %d);\n\n", 
+            INDENT[base_indent], project_name, largest_format_size / 8, 4096 * (largest_format_size / 8));
+  }
+}
+
+
 /**************************************/
 /*!  Emits the if statement executed before
   fetches are performed.
@@ -3836,6 +5014,10 @@ void EmitProcessorBhv( FILE *output, int base_indent ) {
   
   fprintf(output, "%sfor (;;) {\n\n", INDENT[base_indent]);
   base_indent++;
+
+  if( ACCheckpoint )
+    fprintf( output, "%sif (ac_instr_counter >= CKP.save_at) checkpoint_save(ac_instr_counter);\n\n", 
+             INDENT[base_indent]);
   
   EmitFetchInit(output, base_indent);
   
@@ -3854,13 +5036,19 @@ void EmitProcessorBhv( FILE *output, int base_indent ) {
              INDENT[base_indent]);
     fprintf( output, "%scase LOCATION: \\\n", INDENT[base_indent]);
     base_indent++;
+
+    /* the call is counted after it runs */
+    if( ACCheckpoint )
+      EmitCheckpointSyscall(output, base_indent, "ac_instr_counter");
     
     if( ACStatsFlag ){
       fprintf( output, "%sISA.stats[%s_stat_ids::SYSCALLS]++; \\\n", 
               INDENT[base_indent], project_name);
     }
 
-    if( ACDebugFlag ){
+    if( ACBinTrace )
+      fprintf( output, "%sac_bin_trace.instr(ac_pc, 0); \\\n", INDENT[base_indent]);
+    else if( ACDebugFlag ){
       fprintf( output, "%sif( ac_do_trace != 0 )\\\n", INDENT[base_indent]);
       fprintf( output, "%strace_file << hex << ac_pc << dec << endl; \\\n", 
               INDENT[base_indent + 1]);
@@ -3871,6 +5059,8 @@ void EmitProcessorBhv( FILE *output, int base_indent ) {
       fprintf( output, "%sgenerate_trace_for_address(ac_pc);\\\n", INDENT[base_indent]);
     }
 
+    if( ACIntCycles )
+      fprintf( output, "%sflush_cycles(); \\\n", INDENT[base_indent]);
     fprintf( output, "%sISA.syscall.NAME(); \\\n", INDENT[base_indent]);
     
     if (ACSyscallJump)
@@ -3897,11 +5087,9 @@ void EmitProcessorBhv( FILE *output, int base_indent ) {
   }
   
   if( ACFullDecode ) {
-    fprintf( output, "%sinstr_dec = (DEC_CACHE + (ac_pc", 
-             INDENT[base_indent]);
-    if( ACIndexFix ) 
-      fprintf( output, " / %d", largest_format_size / 8);
-    fprintf( output, "));\n");
+    fprintf( output, "%sinstr_dec = ", INDENT[base_indent]);
+    EmitDecCacheEntry( output, "ac_pc", 0);
+    fprintf( output, ";\n");
     fprintf( output, "%sins_id = instr_dec->id;\n\n", INDENT[base_indent]);
   }
   else EmitDecodification(output, base_indent);
@@ -4130,92 +5318,542 @@ void EmitCacheDeclaration( FILE *output, ac_sto_list* pstorage, int base_indent)
     }
     i++;
   }
-  //Printing cache declaration.
-  fprintf( output, "%sac_cache ac_resources::%s(\"%s\", %s, %s, %s, %s, 0x%x);\n",
-           INDENT[base_indent], pstorage->name, pstorage->name, 
-           parm2, parm3, parm4, parm5, wp);
+  //Printing cache declaration.
+  fprintf( output, "%sac_cache ac_resources::%s(\"%s\", %s, %s, %s, %s, 0x%x);\n",
+           INDENT[base_indent], pstorage->name, pstorage->name, 
+           parm2, parm3, parm4, parm5, wp);
+}
+
+
+/**************************************/
+/*!  Emits a Decoder Cache Structure.
+  \brief Used by CreateProcessorHeader function */
+/***************************************/
+void EmitDecCache(FILE *output, int base_indent) {
+  extern ac_dec_format *format_ins_list;
+
+  ac_dec_format *pformat;
+  ac_dec_field *pfield;
+  
+  for (pformat = format_ins_list; pformat != NULL ; pformat = pformat->next) {
+    fprintf(output, "%stypedef struct {\n", INDENT[base_indent]);
+    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
+      fprintf(output, "%s", INDENT[base_indent + 1]);
+      if (!pfield->sign) fprintf(output, "u");
+
+      if (pfield->size < 9) fprintf(output, "int8_t");
+      else if (pfield->size < 17) fprintf(output, "int16_t");
+      else if (pfield->size < 33) fprintf(output, "int32_t");
+      else fprintf(output, "int64_t");
+      
+      fprintf(output, " %s;\n", pfield->name);
+    }
+    fprintf(output, "%s} T_%s;\n\n", INDENT[base_indent], pformat->name);
+  }
+  
+  fprintf(output, "%stypedef struct {\n", INDENT[base_indent]);
+  if( !ACFullDecode ) 
+    fprintf(output, "%sbool valid;\n", INDENT[base_indent + 1]);
+  if (ACThreading)
+    fprintf(output, "%svoid* end_rot;\n", INDENT[base_indent + 1]);
+  if (ACBlockCache)
+    fprintf(output, "%svoid* bb_block;\n", INDENT[base_indent + 1]);
+  if (ACCallThread) {
+    fprintf(output, "%svoid* ct_block;\n", INDENT[base_indent + 1]);
+    fprintf(output, "%sunsigned ct_count;\n", INDENT[base_indent + 1]);
+  }
+  fprintf(output, "%sunsigned id;\n", INDENT[base_indent + 1]);
+  if (ACBBV)
+    fprintf(output, "%sunsigned bbv_id;\n", INDENT[base_indent + 1]);
+  
+  fprintf(output, "%sunion {\n", INDENT[base_indent + 1]);
+  for (pformat = format_ins_list; pformat != NULL ; pformat = pformat->next) {
+    fprintf(output, "%sT_%s F_%s;\n", INDENT[base_indent + 2], 
+            pformat->name, pformat->name);
+  }
+  fprintf(output, "%s};\n", INDENT[base_indent + 1]);
+  fprintf(output, "%s} DecCacheItem ;\n\n", INDENT[base_indent]);
+}
+
+
+/**************************************/
+/*!  Emits the expression addressing the Decoder Cache entry of index.
+  When lookup_only is set, a sparse cache does not allocate a missing
+  page and the expression yields 0 instead.
+  \brief Used by functions that access DEC_CACHE */
+/***************************************/
+void EmitDecCacheEntry(FILE *output, const char *index, int lookup_only) {
+  extern int largest_format_size;
+
+  if( ACSparseDecCache )
+    fprintf( output, "DEC_CACHE.%s(%s", lookup_only ? "find" : "at", index);
+  else
+    fprintf( output, "(DEC_CACHE + (%s", index);
+  if( ACIndexFix ) 
+    fprintf( output, " / %d", largest_format_size / 8);
+  if( ACSparseDecCache )
+    fprintf( output, ")");
+  else
+    fprintf( output, "))");
+}
+
+
+/**************************************/
+/*!  Emits a Decoder Cache Attribution.
+  \brief Used by EmitDecodification function */
+/***************************************/
+void EmitDecCacheAt(FILE *output, int base_indent) {
+  extern ac_dec_format *format_ins_list;
+  ac_dec_format *pformat;
+  ac_dec_field *pfield;
+  
+  fprintf(output, "%sswitch (ISA.instr_format_table[instr_dec->id]) {\n", 
+          INDENT[base_indent]);
+  for (pformat = format_ins_list; pformat != NULL ; pformat = pformat->next) {
+    fprintf(output, "%scase %d:\n", INDENT[base_indent + 1], pformat->id);
+    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) 
+      fprintf(output, "%sinstr_dec->F_%s.%s = ins_cache[%d];\n", 
+              INDENT[base_indent + 2], pformat->name, 
+              pfield->name, pfield->id);
+    fprintf(output, "%sbreak;\n", INDENT[base_indent + 1]);
+  }
+  
+  if( !ACFullDecode ) {
+    fprintf(output, "%sdefault:\n", INDENT[base_indent + 1]);
+    fprintf(output, "%scerr << \"ArchC Error: Unidentified instruction. \" << endl;\n", 
+            INDENT[base_indent + 2]);
+    fprintf(output, "%scerr << \"PC = \" << hex << ac_pc << dec << endl;\n", 
+            INDENT[base_indent + 2]);
+    fprintf(output, "%sstop();\n", INDENT[base_indent + 2]);
+
+    if (ACThreading)
+      fprintf(output, "%slongjmp(ac_env, AC_ACTION_STOP);\n", 
+              INDENT[base_indent + 2]);
+    else 
+      fprintf(output, "%sreturn;\n", INDENT[base_indent + 2]);
+  }
+  
+  fprintf(output, "%s}\n", INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Emits the expression extracting the value of a field from the
+  instruction words at decode_pc, with the same result as the runtime
+  GetBits(): constant shifts and masks, sign extended when needed. The
+  whole expression is parenthesized, as the mask would otherwise bind
+  looser than a comparison with it.
+  \brief Used by EmitInlineDecoder and EmitInlineDecChain functions */
+/***************************************/
+void EmitInlineDecField(FILE *output, ac_dec_field *pfield) {
+  extern int wordsize;
+  int last = pfield->first_bit;
+  int first = last - (pfield->size - 1);
+  int index_first = first / wordsize;
+  int index_last = last / wordsize;
+  int shift, i;
+
+  fprintf(output, "(");
+  if (pfield->sign)
+    fprintf(output, "((long long) (");
+  fprintf(output, "((");
+
+  /* Same word order as GetBits() */
+  for (i = index_first; i < index_last; i++)
+    fprintf(output, "(");
+  for (i = 0; i <= index_last - index_first; i++) {
+    int word = ac_match_endian ? index_last - i : index_first + i;
+    if (i == 0)
+      fprintf(output, "(unsigned long long) ");
+    else
+      fprintf(output, " << %d) | ", wordsize);
+    if (word == 0)
+      fprintf(output, "word0");
+    else
+      fprintf(output, "AC_DEC_WORD(%d)", word);
+  }
+
+  if (!ac_match_endian)
+    shift = wordsize - (last % wordsize + 1);
+  else
+    shift = first % wordsize;
+  if (shift)
+    fprintf(output, ") >> %d)", shift);
+  else
+    fprintf(output, "))");
+
+  if (pfield->sign)
+    fprintf(output, " << %d)) >> %d", 64 - pfield->size, 64 - pfield->size);
+  else if (pfield->size < 64)
+    fprintf(output, " & 0x%llxULL", (1ULL << pfield->size) - 1);
+  fprintf(output, ")");
+}
+
+/**************************************/
+/*!  Emits the decoding of a chain of decoder tree nodes. Nodes checking
+  the same field become a switch; chains mixing fields are tested in
+  order, so an unmatched subtree falls through to the next node just as
+  the backtracking of the runtime decoder does.
+  \brief Used by EmitInlineDecoder function */
+/***************************************/
+void EmitInlineDecChain(FILE *output, ac_decoder *chain, int base_indent) {
+  extern ac_dec_format *format_ins_list;
+  extern ac_decoder_full *decoder;
+  ac_decoder *d;
+  ac_dec_field *pfield;
+  ac_dec_format *pformat;
+  ac_dec_list *plist;
+  int regular = 1;
+
+  for (d = chain; d != NULL; d = d->next)
+    if (d->check->id != chain->check->id)
+      regular = 0;
+
+  if (regular) {
+    pfield = FindDecField(decoder->fields, chain->check->id);
+    fprintf(output, "%sswitch (", INDENT[base_indent]);
+    EmitInlineDecField(output, pfield);
+    fprintf(output, ") {\n");
+  }
+
+  for (d = chain; d != NULL; d = d->next) {
+    pfield = FindDecField(decoder->fields, d->check->id);
+
+    /* Values the field can not hold never match */
+    if (pfield->size < 32 &&
+        (pfield->sign ? (d->check->value < -(1 << (pfield->size - 1)) ||
+                         d->check->value >= (1 << (pfield->size - 1)))
+                      : (d->check->value < 0 ||
+                         d->check->value >= (1 << pfield->size))))
+      continue;
+
+    if (regular)
+      fprintf(output, "%scase %d: {\n", INDENT[base_indent + 1], d->check->value);
+    else {
+      fprintf(output, "%sif (", INDENT[base_indent + 1]);
+      EmitInlineDecField(output, pfield);
+      fprintf(output, " == %d) {\n", d->check->value);
+    }
+
+    if (d->found) {
+      pformat = FindFormat(format_ins_list, d->found->format);
+      for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
+        fprintf(output, "%sinstr_dec->F_%s.%s = ", INDENT[base_indent + 2],
+                pformat->name, pfield->name);
+        for (plist = d->found->dec_list; plist != NULL; plist = plist->next)
+          if (plist->id == pfield->id)
+            break;
+        if (plist)
+          fprintf(output, "%d", plist->value);
+        else
+          EmitInlineDecField(output, pfield);
+        fprintf(output, ";\n");
+      }
+      fprintf(output, "%sreturn %d; // %s\n", INDENT[base_indent + 2],
+              d->found->id, d->found->name);
+    }
+    else if (d->subcheck)
+      EmitInlineDecChain(output, d->subcheck, base_indent + 2);
+
+    if (regular && !d->found)
+      fprintf(output, "%s} break;\n", INDENT[base_indent + 1]);
+    else
+      fprintf(output, "%s}\n", INDENT[base_indent + 1]);
+  }
+
+  if (regular)
+    fprintf(output, "%s}\n", INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Emits a decoder specialized for the model. It walks the decoder
+  tree built by acsim, extracts fields with constant shifts and masks
+  and writes them straight into the decode cache entry, instead of
+  calling the generic runtime decoder and copying its field array.
+  Returns the instruction id, or 0 for an unidentified instruction.
+  All state is passed in or local, so predecode() threads can share it.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitInlineDecoder(FILE *output, int base_indent) {
+  extern ac_decoder_full *decoder;
+
+  fprintf( output, "%sunsigned %s::decode_instr(DecCacheItem* instr_dec, %s_parms::ac_word* buffer, unsigned decode_pc) {\n", 
+           INDENT[base_indent], project_name, project_name);
+
+  base_indent++;
+
+  fprintf( output, "%sint quant = 0;\n", INDENT[base_indent]);
+  fprintf( output, "%s#define AC_DEC_WORD(index) ((index < quant) ? buffer[index] : (quant = ExpandInstrBuffer(buffer, quant, decode_pc, index), buffer[index]))\n\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%s%s_parms::ac_word word0 = AC_DEC_WORD(0);\n\n", 
+           INDENT[base_indent], project_name);
+
+  EmitInlineDecChain(output, decoder->decoder, base_indent);
+
+  fprintf( output, "\n%sreturn 0;\n", INDENT[base_indent]);
+  fprintf( output, "%s#undef AC_DEC_WORD\n", INDENT[base_indent]);
+
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Emits the Full Decode function, which fills the decode cache entries
+  of [first, last). It keeps the decoding state (buffer, decode_pc, field
+  values) in locals shadowing the members used by EmitDecodification, so
+  behavior() can run it on several host threads (predecode_parallel).
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitPredecode(FILE *output, int base_indent) {
+  extern int largest_format_size;
+
+  fprintf( output, "%svoid %s::predecode(unsigned first, unsigned last) {\n", 
+           INDENT[base_indent], project_name);
+
+  base_indent++;
+
+  fprintf( output, "%sac_dec_worker worker(*this, ISA.decoder->nFields);\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%s%s_parms::ac_word* buffer = worker.buffer;\n", 
+           INDENT[base_indent], project_name);
+  fprintf( output, "%sDecCacheItem* instr_dec;\n", INDENT[base_indent]);
+  if( !ACInlineDecoder )
+    fprintf( output, "%sint quant;\n", INDENT[base_indent]);
+  if( ACPersistDecCache )
+    fprintf( output, "%sunsigned decoded = 0;\n", INDENT[base_indent]);
+  fprintf( output, "\n%sfor (unsigned decode_pc = first; decode_pc < last; decode_pc += %d) {\n", 
+           INDENT[base_indent], largest_format_size / 8);
+  fprintf( output, "%sworker.decode_pc = decode_pc;\n", INDENT[base_indent + 1]);
+  EmitDecodification(output, base_indent + 1);
+  fprintf( output, "%s}\n", INDENT[base_indent]);
+  if( ACPersistDecCache )
+    fprintf( output, "%sDEC_FILE.decoded += decoded;\n", INDENT[base_indent]);
+
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Tells whether any instruction was declared with is_jump/is_branch.
+  \brief Used by main and EmitInstrBehavior functions */
+/***************************************/
+int HaveCflow(void) {
+  extern ac_dec_instr *instr_list;
+  ac_dec_instr *pinstr;
+
+  for( pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next)
+    if( pinstr->cflow != NULL )
+      return 1;
+  return 0;
+}
+
+/**************************************/
+/*!  FNV-1a hash of size bytes at data, continuing from h.
+  \brief Used by ModelHash function */
+/***************************************/
+static unsigned long long HashBytes(unsigned long long h, const void *data, size_t size) {
+  const unsigned char *p = data;
+
+  while (size--) {
+    h ^= *p++;
+    h *= 1099511628211ULL;
+  }
+  return h;
 }
 
+static unsigned long long HashString(unsigned long long h, const char *s) {
+  return HashBytes(h, s ? s : "", s ? strlen(s) + 1 : 1);
+}
+
+static unsigned long long HashInt(unsigned long long h, long value) {
+  return HashBytes(h, &value, sizeof(value));
+}
 
 /**************************************/
-/*!  Emits a Decoder Cache Structure.
-  \brief Used by CreateProcessorHeader function */
+/*!  Hashes everything the layout and contents of a saved Decode Cache
+  entry depend on: ArchC version, acsim options, formats, fields and
+  instruction decoding. Simulators generated from a changed model do not
+  accept files saved by older ones.
+  \brief Used by EmitDecCacheFile function */
 /***************************************/
-void EmitDecCache(FILE *output, int base_indent) {
+unsigned long long ModelHash(void) {
   extern ac_dec_format *format_ins_list;
-
+  extern ac_dec_instr *instr_list;
   ac_dec_format *pformat;
   ac_dec_field *pfield;
-  
-  for (pformat = format_ins_list; pformat != NULL ; pformat = pformat->next) {
-    fprintf(output, "%stypedef struct {\n", INDENT[base_indent]);
-    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
-      fprintf(output, "%s", INDENT[base_indent + 1]);
-      if (!pfield->sign) fprintf(output, "u");
+  ac_dec_instr *pinstr;
+  ac_dec_list *pdec;
+  unsigned long long h = 14695981039346656037ULL;
 
-      if (pfield->size < 9) fprintf(output, "int8_t");
-      else if (pfield->size < 17) fprintf(output, "int16_t");
-      else if (pfield->size < 33) fprintf(output, "int32_t");
-      else fprintf(output, "int64_t");
-      
-      fprintf(output, " %s;\n", pfield->name);
+  h = HashString(h, ACVERSION);
+  h = HashString(h, project_name);
+  h = HashString(h, ACOptions);
+
+  for (pformat = format_ins_list; pformat != NULL; pformat = pformat->next) {
+    h = HashString(h, pformat->name);
+    h = HashInt(h, pformat->id);
+    h = HashInt(h, pformat->size);
+    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) {
+      h = HashString(h, pfield->name);
+      h = HashInt(h, pfield->size);
+      h = HashInt(h, pfield->first_bit);
+      h = HashInt(h, pfield->id);
+      h = HashInt(h, pfield->sign);
     }
-    fprintf(output, "%s} T_%s;\n\n", INDENT[base_indent], pformat->name);
   }
-  
-  fprintf(output, "%stypedef struct {\n", INDENT[base_indent]);
-  if( !ACFullDecode ) 
-    fprintf(output, "%sbool valid;\n", INDENT[base_indent + 1]);
-  if (ACThreading)
-    fprintf(output, "%svoid* end_rot;\n", INDENT[base_indent + 1]);
-  fprintf(output, "%sunsigned id;\n", INDENT[base_indent + 1]);
-  
-  fprintf(output, "%sunion {\n", INDENT[base_indent + 1]);
-  for (pformat = format_ins_list; pformat != NULL ; pformat = pformat->next) {
-    fprintf(output, "%sT_%s F_%s;\n", INDENT[base_indent + 2], 
-            pformat->name, pformat->name);
+
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
+    h = HashString(h, pinstr->name);
+    h = HashString(h, pinstr->format);
+    h = HashInt(h, pinstr->id);
+    h = HashInt(h, pinstr->size);
+    for (pdec = pinstr->dec_list; pdec != NULL; pdec = pdec->next) {
+      h = HashString(h, pdec->name);
+      h = HashInt(h, pdec->value);
+    }
   }
-  fprintf(output, "%s};\n", INDENT[base_indent + 1]);
-  fprintf(output, "%s} DecCacheItem ;\n\n", INDENT[base_indent]);
+
+  return h;
 }
 
+/**************************************/
+/*!  Emits load_dec_cache() and save_dec_cache(), which copy the
+  decoded instructions of the program's code from and to the Decode
+  Cache file kept by ac_dec_cache_file. Only the id and format fields
+  of an entry are saved; interpretation routines are taken again from
+  IntRoutine when loading.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitDecCacheFile(FILE *output, int base_indent) {
+  extern ac_dec_instr *instr_list;
+  extern int largest_format_size;
+  ac_dec_instr *pinstr;
+  unsigned max_id = 0;
+  unsigned step = ACIndexFix ? largest_format_size / 8 : 1;
+
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next)
+    if (pinstr->id > max_id)
+      max_id = pinstr->id;
+
+  /* load_dec_cache() */
+  fprintf( output, "%s// Fills the decode cache with instructions saved by a previous run\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%svoid %s::load_dec_cache() {\n", INDENT[base_indent], project_name);
+  base_indent++;
+  fprintf( output, "%sstd::vector<std::pair<unsigned, unsigned> > ranges = code_ranges(ac_pc, dec_cache_size);\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%sconst size_t size = sizeof(DecCacheItem) - offsetof(DecCacheItem, id);\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%sDecCacheItem* instr_dec;\n", INDENT[base_indent]);
+  fprintf( output, "%sconst void* entry;\n", INDENT[base_indent]);
+  fprintf( output, "%sunsigned addr;\n\n", INDENT[base_indent]);
+
+  fprintf( output, "%sif (!DEC_FILE.open(ac_dec_cache_dir, \"%s\", 0x%016llxULL, image_hash(ranges),\n", 
+           INDENT[base_indent], project_name, ModelHash());
+  fprintf( output, "%s                   ranges, size, dec_cache_size, %u))\n", 
+           INDENT[base_indent], max_id);
+  fprintf( output, "%sreturn;\n\n", INDENT[base_indent + 1]);
+
+  fprintf( output, "%swhile ((entry = DEC_FILE.next(addr))) {\n", INDENT[base_indent]);
+  fprintf( output, "%sinstr_dec = ", INDENT[base_indent + 1]);
+  EmitDecCacheEntry( output, "addr", 0);
+  fprintf( output, ";\n");
+  fprintf( output, "%smemcpy(&instr_dec->id, entry, size);\n", INDENT[base_indent + 1]);
+  if( !ACFullDecode )
+    fprintf( output, "%sinstr_dec->valid = true;\n", INDENT[base_indent + 1]);
+  if( ACThreading )
+    fprintf( output, "%sinstr_dec->end_rot = IntRoutine[instr_dec->id];\n", 
+             INDENT[base_indent + 1]);
+  if( ACPlugins )
+    fprintf( output, "%sif (PLUGINS.active() && PLUGINS.decoded(addr, instr_dec->id)) instr_dec->end_rot = PluginEntry;\n", 
+             INDENT[base_indent + 1]);
+  fprintf( output, "%s}\n", INDENT[base_indent]);
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+
+  /* save_dec_cache() */
+  fprintf( output, "%s// Writes the decoded instructions of the program back to its decode cache file\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%svoid %s::save_dec_cache() {\n", INDENT[base_indent], project_name);
+  base_indent++;
+  fprintf( output, "%sDecCacheItem* instr_dec;\n\n", INDENT[base_indent]);
+  fprintf( output, "%sif (!DEC_FILE.begin_save())\n", INDENT[base_indent]);
+  fprintf( output, "%sreturn;\n\n", INDENT[base_indent + 1]);
+
+  fprintf( output, "%sfor (unsigned i = 0; i < DEC_FILE.ranges.size(); i++) {\n", INDENT[base_indent]);
+  fprintf( output, "%sunsigned first = DEC_FILE.ranges[i].first;\n", INDENT[base_indent + 1]);
+  fprintf( output, "%sunsigned last = std::min(DEC_FILE.ranges[i].second, dec_cache_size);\n\n", 
+           INDENT[base_indent + 1]);
+  if (step > 1)
+    fprintf( output, "%sfor (unsigned addr = first - first %% %d; addr < last; addr += %d) {\n", 
+             INDENT[base_indent + 1], step, step);
+  else
+    fprintf( output, "%sfor (unsigned addr = first; addr < last; addr++) {\n", 
+             INDENT[base_indent + 1]);
+  fprintf( output, "%sinstr_dec = ", INDENT[base_indent + 2]);
+  EmitDecCacheEntry( output, "addr", 1);
+  fprintf( output, ";\n");
+  /* entries with id 0 hold the syscall routines or were never decoded */
+  fprintf( output, "%sif (%s%sinstr_dec->id)\n", INDENT[base_indent + 2],
+           ACSparseDecCache ? "instr_dec && " : "",
+           ACFullDecode ? "" : "instr_dec->valid && ");
+  fprintf( output, "%sDEC_FILE.put(addr, &instr_dec->id);\n", INDENT[base_indent + 3]);
+  fprintf( output, "%s}\n", INDENT[base_indent + 1]);
+  fprintf( output, "%s}\n", INDENT[base_indent]);
+  fprintf( output, "%sDEC_FILE.end_save();\n", INDENT[base_indent]);
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+}
 
 /**************************************/
-/*!  Emits a Decoder Cache Attribution.
-  \brief Used by EmitDecodification function */
+/*!  Emits the per-instruction part of the Dispatch Functions,
+  executed once the decode cache entry of ac_pc is known.
+  \brief Used by EmitDispatch and EmitBlockDispatch functions */
 /***************************************/
-void EmitDecCacheAt(FILE *output, int base_indent) {
-  extern ac_dec_format *format_ins_list;
-  ac_dec_format *pformat;
-  ac_dec_field *pfield;
+void EmitDispatchInstr(FILE *output, int base_indent) {
+
+  EmitInstrExecIni(output, base_indent);
   
-  fprintf(output, "%sswitch (ISA.instr_format_table[instr_dec->id]) {\n", 
-          INDENT[base_indent]);
-  for (pformat = format_ins_list; pformat != NULL ; pformat = pformat->next) {
-    fprintf(output, "%scase %d:\n", INDENT[base_indent + 1], pformat->id);
-    for (pfield = pformat->fields; pfield != NULL; pfield = pfield->next) 
-      fprintf(output, "%sinstr_dec->F_%s.%s = ins_cache[%d];\n", 
-              INDENT[base_indent + 2], pformat->name, 
-              pfield->name, pfield->id);
-    fprintf(output, "%sbreak;\n", INDENT[base_indent + 1]);
+  if( ACStatsFlag ){
+    fprintf( output, "%sif(!ac_wait_sig && ins_id) {\n", INDENT[base_indent]);
+    fprintf( output, "%sISA.stats[%s_stat_ids::INSTRUCTIONS]++;\n", 
+            INDENT[base_indent + 1], project_name);
+    fprintf( output, "%s(*(ISA.instr_stats[ins_id]))[%s_instr_stat_ids::COUNT]++;\n", 
+            INDENT[base_indent + 1], project_name);
+    fprintf( output, "%s}\n", INDENT[base_indent]);
   }
-  
-  if( !ACFullDecode ) {
-    fprintf(output, "%sdefault:\n", INDENT[base_indent + 1]);
-    fprintf(output, "%scerr << \"ArchC Error: Unidentified instruction. \" << endl;\n", 
-            INDENT[base_indent + 2]);
-    fprintf(output, "%scerr << \"PC = \" << hex << ac_pc << dec << endl;\n", 
-            INDENT[base_indent + 2]);
-    fprintf(output, "%sstop();\n", INDENT[base_indent + 2]);
 
-    if (ACThreading)
-      fprintf(output, "%slongjmp(ac_env, AC_ACTION_STOP);\n", 
-              INDENT[base_indent + 2]);
-    else 
-      fprintf(output, "%sreturn;\n", INDENT[base_indent + 2]);
+  if( ACBinTrace )
+    fprintf( output, "%sac_bin_trace.instr(ac_pc, ins_id);\n", INDENT[base_indent]);
+  else if( ACDebugFlag ){
+    fprintf( output, "%sif( ac_do_trace != 0 ) \n", INDENT[base_indent]);
+    fprintf( output, PRINT_TRACE, INDENT[base_indent + 1]);
+  }
+  if( ACHLTraceFlag)
+  {
+    fprintf( output, "%sgenerate_trace_for_address(ac_pc);\\\n", INDENT[base_indent]);
   }
+  if( ACProfile )
+    fprintf( output, "%sPROFILE.tick(ac_pc);\n", INDENT[base_indent]);
+  if( ACIntervalStats )
+    fprintf( output, "%sif (ac_instr_counter >= INTERVALS.next_instr) interval_sample();\n", 
+             INDENT[base_indent]);
+  if( ACBBV )
+    EmitBBVEnter(output, base_indent, "ac_instr_counter");
   
-  fprintf(output, "%s}\n", INDENT[base_indent]);
+  if (ACVerboseFlag) {
+    if( ACABIFlag )
+      fprintf( output, "%sdone.write(1);\n", INDENT[base_indent]);
+    else
+      fprintf( output, "%sbhv_done.write(1);\n", INDENT[base_indent]);
+  }
+
+// POWER ESTIMATION
+
+  if (ACPowerEnable) {
+    fprintf(output, "\n\n#ifdef POWER_SIM\n");
+    fprintf(output, "ps.update_stat_power(ins_id);\n");
+    fprintf(output, "#endif\n\n");
+  }
 }
 
 /**************************************/
@@ -4247,13 +5885,27 @@ void EmitDispatch(FILE *output, int base_indent) {
     fprintf( output, "%sextern bool ac_do_trace;\n", INDENT[base_indent]);
     fprintf( output, "%sextern ofstream trace_file;\n", INDENT[base_indent]);
   }
+
+  /* between instructions, so the checkpoint restarts at ac_pc */
+  if( ACCheckpoint )
+    fprintf( output, "%sif (ac_instr_counter >= CKP.save_at) checkpoint_save(ac_instr_counter);\n\n", 
+             INDENT[base_indent]);
+
+  /* leave_at is 0 outside the detailed regions */
+  if( ACFastForward ) {
+    fprintf( output, "%sif (ac_instr_counter >= FASTFWD.leave_at) {\n", INDENT[base_indent]);
+    fprintf( output, "%sif (FASTFWD.detailed()) fast_forward_switch();\n", INDENT[base_indent + 1]);
+    fprintf( output, "%sif (void* rot = dispatch_fast()) return rot;\n", INDENT[base_indent + 1]);
+    fprintf( output, "%s}\n\n", INDENT[base_indent]);
+  }
   
   //!Emit update method.
   EmitUpdateMethod( output, base_indent);
   
   EmitFetchInit(output, base_indent);
   
-  fprintf( output, "%sac_instr_counter++;\n", INDENT[base_indent]);
+  if( !ACCallThread )
+    fprintf( output, "%sac_instr_counter++;\n", INDENT[base_indent]);
   fprintf( output, "%sunsigned ins_id;\n", INDENT[base_indent]);
   
  
@@ -4276,12 +5928,18 @@ void EmitDispatch(FILE *output, int base_indent) {
     fprintf( output, "%scase LOCATION: \\\n", INDENT[base_indent]);
     base_indent++;
 
+    /* the call was counted above */
+    if( ACCheckpoint )
+      EmitCheckpointSyscall(output, base_indent, "ac_instr_counter - 1");
+
     if( ACStatsFlag ){
       fprintf( output, "%sISA.stats[%s_stat_ids::SYSCALLS]++; \\\n", 
               INDENT[base_indent], project_name);
     }
 
-    if( ACDebugFlag ){
+    if( ACBinTrace )
+      fprintf( output, "%sac_bin_trace.instr(ac_pc, 0); \\\n", INDENT[base_indent]);
+    else if( ACDebugFlag ){
       fprintf( output, "%sif( ac_do_trace != 0 )\\\n", INDENT[base_indent]);
       fprintf( output, "%strace_file << hex << ac_pc << dec << endl; \\\n", 
               INDENT[base_indent + 1]);
@@ -4291,6 +5949,8 @@ void EmitDispatch(FILE *output, int base_indent) {
       fprintf( output, "%sgenerate_trace_for_address(ac_pc);\\\n", INDENT[base_indent]);
     }
 
+    if( ACIntCycles )
+      fprintf( output, "%sflush_cycles(); \\\n", INDENT[base_indent]);
     fprintf( output, "%sISA.syscall.NAME(); \\\n", INDENT[base_indent]);
     
     if (ACSyscallJump)
@@ -4321,35 +5981,23 @@ void EmitDispatch(FILE *output, int base_indent) {
   }
   
   if( ACFullDecode ) {
-    fprintf( output, "%sinstr_dec = (DEC_CACHE + (ac_pc", 
-             INDENT[base_indent]);
-    if( ACIndexFix ) 
-      fprintf( output, " / %d", largest_format_size / 8);
-    fprintf( output, "));\n");
+    fprintf( output, "%sinstr_dec = ", INDENT[base_indent]);
+    EmitDecCacheEntry( output, "ac_pc", 0);
+    fprintf( output, ";\n");
     fprintf( output, "%sins_id = instr_dec->id;\n\n", INDENT[base_indent]);
   }
   else EmitDecodification(output, base_indent);
-  
-  EmitInstrExecIni(output, base_indent);
-  
-  if( ACStatsFlag ){
-    fprintf( output, "%sif(!ac_wait_sig && ins_id) {\n", INDENT[base_indent]);
-    fprintf( output, "%sISA.stats[%s_stat_ids::INSTRUCTIONS]++;\n", 
-            INDENT[base_indent + 1], project_name);
-    fprintf( output, "%s(*(ISA.instr_stats[ins_id]))[%s_instr_stat_ids::COUNT]++;\n", 
-            INDENT[base_indent + 1], project_name);
-    fprintf( output, "%s}\n", INDENT[base_indent]);
-  }
 
-  if( ACDebugFlag ){
-    fprintf( output, "%sif( ac_do_trace != 0 ) \n", INDENT[base_indent]);
-    fprintf( output, PRINT_TRACE, INDENT[base_indent + 1]);
-  }
-  if( ACHLTraceFlag)
-  {
-    fprintf( output, "%sgenerate_trace_for_address(ac_pc);\\\n", INDENT[base_indent]);
+  if( ACCallThread ) {
+    fprintf( output, "%sif (instr_dec->ct_block ||\n", INDENT[base_indent]);
+    fprintf( output, "%s(++instr_dec->ct_count == AC_CT_THRESHOLD && ct_build(instr_dec)))\n", 
+             INDENT[base_indent + 2]);
+    fprintf( output, "%sreturn CallThreadEntry;\n", INDENT[base_indent + 1]);
+    fprintf( output, "%sac_instr_counter++;\n\n", INDENT[base_indent]);
   }
   
+  EmitDispatchInstr(output, base_indent);
+
   if( ACABIFlag && !ACDecCacheFlag ) {
       base_indent--;
     if( ACSyscallJump ) {
@@ -4362,23 +6010,22 @@ void EmitDispatch(FILE *output, int base_indent) {
     }
   }
   
-  if (ACVerboseFlag) {
-    if( ACABIFlag )
-      fprintf( output, "%sdone.write(1);\n", INDENT[base_indent]);
-    else
-      fprintf( output, "%sbhv_done.write(1);\n", INDENT[base_indent]);
-  }
-
-// POWER ESTIMATION
+  if(ACHostCost)
+    fprintf( output, "%sif (HOSTCOST.tick()) return HostCostEntry;\n", INDENT[base_indent]);
 
-  if (ACPowerEnable) {
-    fprintf(output, "\n\n#ifdef POWER_SIM\n");
-    fprintf(output, "ps.update_stat_power(ins_id);\n");
-    fprintf(output, "#endif\n\n");
+  if(ACBlockCache) {
+    if(ACGDBPatch) {
+      fprintf( output, "%svoid* rot = BB.enter(instr_dec, ac_pc, ISA.instr_table[ins_id].ac_instr_size);\n", 
+               INDENT[base_indent]);
+      fprintf( output, "%sreturn gdb_step ? BreakEntry : rot;\n", INDENT[base_indent]);
+    }
+    else
+      fprintf( output, "%sreturn BB.enter(instr_dec, ac_pc, ISA.instr_table[ins_id].ac_instr_size);\n", 
+               INDENT[base_indent]);
   }
-
-  
-  if(ACDecCacheFlag)
+  else if(ACGDBPatch)
+    fprintf( output, "%sreturn gdb_step ? BreakEntry : instr_dec->end_rot;\n", INDENT[base_indent]);  
+  else if(ACDecCacheFlag)
     fprintf( output, "%sreturn instr_dec->end_rot;\n", INDENT[base_indent]);  
   else
     fprintf( output, "%sreturn IntRoutine[ins_id];\n", INDENT[base_indent]);  
@@ -4388,6 +6035,191 @@ void EmitDispatch(FILE *output, int base_indent) {
 }
 
 
+/**************************************/
+/*!  Emits the in-block Dispatch Function used by the Basic Block Cache.
+  Instructions without control flow go on to the next instruction of
+  their block (see ac_block_cache.H) through this function: the stop,
+  quantum, bounds and decode work was done by dispatch() when the block
+  was entered, so it only checks that ac_pc reached the next instruction
+  and runs the per-instruction hooks of the options generated (counter,
+  traces, statistics, ...). Otherwise the block is left through
+  I_BlockExit and dispatch().
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitBlockDispatch(FILE *output, int base_indent) {
+
+  fprintf( output, "%svoid* %s::dispatch_block() {\n", 
+           INDENT[base_indent], project_name);
+
+  base_indent++;
+
+  if( ACDebugFlag ){
+    fprintf( output, "%sextern bool ac_do_trace;\n", INDENT[base_indent]);
+    fprintf( output, "%sextern ofstream trace_file;\n", INDENT[base_indent]);
+  }
+
+  fprintf( output, "%sif (ac_pc != (++BB.cur)->pc)\n", INDENT[base_indent]);
+  fprintf( output, "%sreturn BlockExit;\n\n", INDENT[base_indent + 1]);
+
+  /* between instructions, so the checkpoint restarts at ac_pc */
+  if( ACCheckpoint )
+    fprintf( output, "%sif (ac_instr_counter >= CKP.save_at) checkpoint_save(ac_instr_counter);\n", 
+             INDENT[base_indent]);
+
+  fprintf( output, "%sinstr_dec = BB.cur->dec;\n", INDENT[base_indent]);
+  fprintf( output, "%sac_instr_counter++;\n", INDENT[base_indent]);
+  fprintf( output, "%sunsigned ins_id = instr_dec->id;\n\n", INDENT[base_indent]);
+
+  EmitDispatchInstr(output, base_indent);
+
+  fprintf( output, "%sreturn %sBB.cur->rot;\n", INDENT[base_indent], 
+           ACGDBPatch ? "gdb_step ? BreakEntry : " : "");
+
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);  
+}
+
+/**************************************/
+/*!  Emits the call threading support: one function per instruction, doing
+  the dispatch work and running the behavior of the instruction as the
+  threaded interpreter would, and ct_build(), which chains calls to them
+  for the instructions following ac_pc into call-threaded host code (see
+  ac_call_thread.H); behaviors themselves are not compiled. Blocks end
+  at control flow instructions, at the first instruction not decoded yet
+  or after AC_CT_MAX_BLOCK instructions. At run time they are also left
+  as soon as ac_pc does not reach the next instruction.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitCallThread(FILE *output, int base_indent) {
+  extern ac_dec_instr *instr_list;
+  ac_dec_instr *pinstr;
+
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next) {
+    fprintf( output, "%s// Call-threaded instruction %s\n", INDENT[base_indent], pinstr->name);
+    fprintf( output, "%sint %s::ct_%s(DecCacheItem* dec, unsigned next_pc) {\n", 
+             INDENT[base_indent], project_name, pinstr->name);
+    base_indent++;
+
+    if( ACDebugFlag ){
+      fprintf( output, "%sextern bool ac_do_trace;\n", INDENT[base_indent]);
+      fprintf( output, "%sextern ofstream trace_file;\n", INDENT[base_indent]);
+    }
+    fprintf( output, "%sunsigned ins_id = %d;\n\n", INDENT[base_indent], pinstr->id);
+    fprintf( output, "%sinstr_dec = dec;\n", INDENT[base_indent]);
+    fprintf( output, "%sac_instr_counter++;\n", INDENT[base_indent]);
+
+    EmitDispatchInstr(output, base_indent);
+    EmitInstrBehavior(output, pinstr, base_indent, 0);
+
+    fprintf( output, "%sreturn ac_pc != next_pc", INDENT[base_indent]);
+    if( ACWaitFlag && !ACIntCycles )
+      fprintf( output, " || ac_qk.need_sync()");
+    if( !ACLongJmpStop )
+      fprintf( output, " || ac_stop_flag");
+    fprintf( output, ";\n");
+
+    base_indent--;
+    fprintf( output, "%s}\n\n", INDENT[base_indent]);
+  }
+
+  fprintf( output, "%s// Builds the block starting at ac_pc as a chain of calls\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%sbool %s::ct_build(DecCacheItem* head) {\n", 
+           INDENT[base_indent], project_name);
+  base_indent++;
+
+  /* instruction ids follow instr_list */
+  fprintf( output, "%sstatic void* const functions[] = {0", INDENT[base_indent]);
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next)
+    fprintf( output, ",\n%s(void*) &ac_call_thread_step<%s, DecCacheItem, &%s::ct_%s>", 
+             INDENT[base_indent + 1], project_name, project_name, pinstr->name);
+  fprintf( output, "};\n");
+  fprintf( output, "%sstatic const bool ends_block[] = {true", INDENT[base_indent]);
+  for (pinstr = instr_list; pinstr != NULL; pinstr = pinstr->next)
+    fprintf( output, ", %s", pinstr->cflow ? "true" : "false");
+  fprintf( output, "};\n");
+  fprintf( output, "%sDecCacheItem* dec = head;\n", INDENT[base_indent]);
+  fprintf( output, "%sunsigned pc = ac_pc;\n\n", INDENT[base_indent]);
+
+  /* instructions redirected to the plugins stay in the interpreter */
+  fprintf( output, "%sif (!head->id || %s!CT.begin_block())\n", INDENT[base_indent],
+           ACPlugins ? "head->end_rot != IntRoutine[head->id] || " : "");
+  fprintf( output, "%sreturn false;\n\n", INDENT[base_indent + 1]);
+
+  fprintf( output, "%sfor (unsigned n = 1; ; n++) {\n", INDENT[base_indent]);
+  fprintf( output, "%sunsigned next_pc = pc + ISA.instr_table[dec->id].ac_instr_size;\n\n", 
+           INDENT[base_indent + 1]);
+  fprintf( output, "%sCT.emit_call(functions[dec->id], dec, next_pc);\n", INDENT[base_indent + 1]);
+  fprintf( output, "%sif (n == AC_CT_MAX_BLOCK || ends_block[dec->id] || next_pc >= dec_cache_size)\n", 
+           INDENT[base_indent + 1]);
+  fprintf( output, "%sbreak;\n", INDENT[base_indent + 2]);
+  fprintf( output, "%sdec = ", INDENT[base_indent + 1]);
+  EmitDecCacheEntry( output, "next_pc", 1);
+  fprintf( output, ";\n");
+  fprintf( output, "%sif (%s%s!dec->id%s)\n", INDENT[base_indent + 1],
+           ACSparseDecCache ? "!dec || " : "",
+           ACFullDecode ? "" : "!dec->valid || ",
+           ACPlugins ? " || dec->end_rot != IntRoutine[dec->id]" : "");
+  fprintf( output, "%sbreak;\n", INDENT[base_indent + 2]);
+  fprintf( output, "%spc = next_pc;\n", INDENT[base_indent + 1]);
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+
+  fprintf( output, "%shead->ct_block = (void*) CT.end_block();\n", INDENT[base_indent]);
+  fprintf( output, "%sreturn head->ct_block != 0;\n", INDENT[base_indent]);
+  base_indent--;
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+}
+
+/**************************************/
+/*!  Emits the GDB support used with the Decode Cache and Threading.
+  Decode cache entries holding a breakpoint run I_Break instead of their
+  interpretation routine, and dispatch() sends every instruction there
+  while GDB steps, so no check is made per instruction otherwise.
+  \brief Used by CreateProcessorImpl function */
+/***************************************/
+void EmitGDBBreak(FILE *output, int base_indent) {
+  const char *patch[] = {"BreakEntry", "IntRoutine[dec->id]"};
+  const char *name[] = {"inserted", "removed"};
+  const char *what[] = {"Redirects the decoded instruction at address to I_Break",
+                        "Restores the interpretation routine of the instruction at address"};
+  int i;
+
+  fprintf( output, "%s// Hands control to GDB and returns the routine to go on with\n", 
+           INDENT[base_indent]);
+  fprintf( output, "%svoid* %s::gdb_break() {\n", INDENT[base_indent], project_name);
+  fprintf( output, "%sunsigned pc = ac_pc;\n\n", INDENT[base_indent + 1]);
+  fprintf( output, "%sgdbstub->process_bp();\n", INDENT[base_indent + 1]);
+  fprintf( output, "%sgdb_step = gdbstub->stepping();\n", INDENT[base_indent + 1]);
+  COMMENT(INDENT[base_indent + 1], "GDB may have moved on to another address.");
+  fprintf( output, "%sif (ac_pc != pc)\n", INDENT[base_indent + 1]);
+  fprintf( output, "%sreturn dispatch();\n", INDENT[base_indent + 2]);
+  fprintf( output, "%sreturn IntRoutine[instr_dec->id];\n", INDENT[base_indent + 1]);
+  fprintf( output, "%s}\n\n", INDENT[base_indent]);
+
+  /* entries with id 0 hold the syscall routines or were never decoded;
+     the ones decoded later look the breakpoints up themselves */
+  for (i = 0; i < 2; i++) {
+    fprintf( output, "%s// %s\n", INDENT[base_indent], what[i]);
+    fprintf( output, "%svoid %s::break_%s(unsigned int address) {\n", 
+             INDENT[base_indent], project_name, name[i]);
+    base_indent++;
+    fprintf( output, "%sDecCacheItem* dec;\n\n", INDENT[base_indent]);
+    fprintf( output, "%sif (address >= dec_cache_size)\n", INDENT[base_indent]);
+    fprintf( output, "%sreturn;\n", INDENT[base_indent + 1]);
+    fprintf( output, "%sdec = ", INDENT[base_indent]);
+    EmitDecCacheEntry( output, "address", 1);
+    fprintf( output, ";\n");
+    fprintf( output, "%sif (%s%sdec->id)\n", INDENT[base_indent],
+             ACSparseDecCache ? "dec && " : "",
+             ACFullDecode ? "" : "dec->valid && ");
+    fprintf( output, "%sdec->end_rot = %s;\n", INDENT[base_indent + 1], patch[i]);
+    if (ACBlockCache)
+      fprintf( output, "%sBB.leave();\n", INDENT[base_indent]);
+    base_indent--;
+    fprintf( output, "%s}\n\n", INDENT[base_indent]);
+  }
+}
+
 /**************************************/
 /*!  Emits the Vector with Address of the 
  * Interpretation Routines used by Threading
@@ -4410,6 +6242,21 @@ void EmitVetLabelAt(FILE *output, int base_indent) {
   fprintf(output, "};\n\n");
   
   fprintf(output, "%sIntRoutine = vet;\n\n", INDENT[base_indent]);
+
+  if (ACBlockCache)
+    fprintf(output, "%sBlockExit = &&I_BlockExit;\n\n", INDENT[base_indent]);
+
+  if (ACCallThread)
+    fprintf(output, "%sCallThreadEntry = &&I_CallThread;\n\n", INDENT[base_indent]);
+
+  if (ACGDBPatch)
+    fprintf(output, "%sBreakEntry = &&I_Break;\n\n", INDENT[base_indent]);
+
+  if (ACPlugins)
+    fprintf(output, "%sPluginEntry = &&I_Plugin;\n\n", INDENT[base_indent]);
+
+  if (ACHostCost)
+    fprintf(output, "%sHostCostEntry = &&I_HostCost;\n\n", INDENT[base_indent]);
 }
 
 
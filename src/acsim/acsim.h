@@ -123,6 +123,23 @@ enum _ac_cmd_options {
   OPFullDecode,
   OPCurInstrID,
   OPPower,
+  OPBlockCache,
+  OPSparseDecCache,
+  OPSelfModCode,
+  OPInlineDecoder,
+  OPPersistDecCache,
+  OPCallThread,
+  OPIntCycles,
+  OPPlugins,
+  OPBinTrace,
+  OPProfile,
+  OPCallGraph,
+  OPHostCost,
+  OPIntervalStats,
+  OPFastForward,
+  OPBBV,
+  OPCheckpoint,
+  OPForkServer,
   ACNumberOfOptions,
 };
 
@@ -217,12 +234,35 @@ void CreateIntrTLM2Tmpl(void); /*****/
 void EmitUpdateMethod( FILE *output, int base_indent );                            //!< Emit reg update method for non-pipelined architectures.
 void EmitProcessorBhv( FILE *output, int base_indent);                             //!< Emit processor behavior for a single-cycle processor.
 void EmitInstrExec(FILE *output, int base_indent);                                 //!< Emit code for executing an instruction behavior
+void EmitInstrBehavior(FILE *output, ac_dec_instr *pinstr, int base_indent, int timed); //!< Emit the behavior method calls of one instruction
+void EmitHostCostExec(FILE *output, int base_indent);                              //!< Emit the routine timing sampled instructions
+void EmitIntervalOpen(FILE *output, int base_indent);                              //!< Emit the counters of the interval statistics
+void EmitIntervalSample(FILE *output);                                             //!< Emit the method sampling an interval
+void EmitFastForwardCaches(FILE *output, int base_indent, const char *method);    //!< Emit a call saving or restoring the cache statistics
+void EmitBBVEnter(FILE *output, int base_indent, const char *count);               //!< Emit the basic block vector update of an instruction
+void EmitFastDispatch(FILE *output, int base_indent);                              //!< Emit the functional dispatch of --fast-forward
+void EmitFastForwardSwitch(FILE *output);                                          //!< Emit the method switching between the dispatches
+void EmitCheckpointState(FILE *output, const char *dir);                           //!< Emit the sections of a checkpoint, put or get
+void EmitCheckpoint(FILE *output);                                                 //!< Emit the methods saving and restoring checkpoints
+void EmitCheckpointSyscall(FILE *output, int base_indent, const char *count);      //!< Emit the checkpoint trigger of a system call
+void EmitDecodeWarmup(FILE *output, int base_indent);                              //!< Emit the decode cache loading and full decode
+void EmitCallGraphBranch(FILE *output, ac_dec_instr *pinstr, ac_dec_format *pformat, int base_indent); //!< Emit the call graph report of a control flow instruction
 void EmitDecodification(FILE *output, int base_indent);                            //!< Emit for instruction decodification
 void EmitFetchInit(FILE *output, int base_indent);                                 //!< Emit code used for initializing fetchs
 void EmitCacheDeclaration(FILE *output, ac_sto_list* pstorage, int base_indent);   //!< Emit code for ac_cache object declaration
 void EmitDecCache(FILE *output, int base_indent);                                  //!< Emits a Decoder Cache Structure
 void EmitDecCacheAt(FILE *output, int base_indent);                                //!< Emits a Decoder Cache Attribution
+void EmitDecCacheEntry(FILE *output, const char *index, int lookup_only);          //!< Emits the address of a Decoder Cache entry
+void EmitPredecode(FILE *output, int base_indent);                                 //!< Emits the Full Decode function run by predecode threads
+void EmitInlineDecoder(FILE *output, int base_indent);                             //!< Emits the model-specific Decoder Function
+void EmitDecCacheFile(FILE *output, int base_indent);                              //!< Emits the functions loading and saving the Decode Cache file
+void EmitInlineDecChain(FILE *output, ac_decoder *chain, int base_indent);         //!< Emits the decoding of one level of the decoder tree
+void EmitInlineDecField(FILE *output, ac_dec_field *pfield);                       //!< Emits the expression extracting a field value
 void EmitDispatch(FILE *output, int base_indent);                                  //!< Emits the Dispatch Function used by Threading
+void EmitDispatchInstr(FILE *output, int base_indent);                             //!< Emits the per-instruction part of the Dispatch Functions
+void EmitBlockDispatch(FILE *output, int base_indent);                             //!< Emits the in-block Dispatch Function used by the Basic Block Cache
+void EmitCallThread(FILE *output, int base_indent);                                //!< Emits the functions and the block builder used by call threading
+void EmitGDBBreak(FILE *output, int base_indent);                                  //!< Emits the GDB break routine and the breakpoint redirection methods
 void EmitVetLabelAt(FILE *output, int base_indent);                                //!< Emits the Vector with Address of the Interpretation Routines used by Threading
 //@}
 
@@ -240,6 +280,8 @@ void EnumerateCaches(void);
 void GetFetchDevice(void);
 void GetLoadDevice(void);
 void GetFirstLevelDataDevice(void);
+unsigned long long ModelHash(void);               //!< Hash of the ISA and options the Decode Cache layout depends on.
+int HaveCflow(void);                              //!< Tells whether any instruction declares control flow.
 
 
 //@}